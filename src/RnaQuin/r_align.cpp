@@ -1,4 +1,6 @@
 #include "tools/errors.hpp"
+#include "tools/ctpl_stl.h"
+#include "data/sweep.hpp"
 #include "tools/gtf_data.hpp"
 #include "RnaQuin/r_align.hpp"
 #include "RnaQuin/RnaQuin.hpp"
@@ -36,6 +38,7 @@ static RAlign::Stats init()
 
     RAlign::Stats stats;
 
+    // Copies of the intervals shared by the reference, alignments are mapped to them
     stats.iInters = gtf->uiInters();
 
     /*
@@ -204,17 +207,103 @@ RAlign::Stats calculate(const RAlign::Options &o, std::function<void (RAlign::St
     return stats;
 }
 
-static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::Data &align)
+/*
+ * Per-chromosome state, indexed by the chromosome in the header rather than the name. Thus,
+ * there's no string work for each alignment. Each chromosome is set up on its first alignment.
+ * Sweep-lines over the reference exons and introns are only for coordinate-sorted alignments.
+ */
+
+class Chrs
 {
-    static Locus l;
-    static bool spliced;
+    public:
+    
+        struct Chr
+        {
+            bool init = false;
+        
+            bool isChrIS = false;
+        
+            // Null if the chromosome is not annotated
+            RAlign::Stats::Data *data = nullptr;
+        
+            const MergedIntervals<> *e = nullptr;
+            const MergedIntervals<> *i = nullptr;
+        
+            // Null if the alignments are unsorted
+            std::shared_ptr<SweepIntervals<MergedInterval>> se, si;
+        };
 
-    if (!stats.data.count(align.cID))
+        Chrs(RAlign::Stats &stats, bool sorted) : _stats(stats), _sorted(sorted) {}
+    
+        inline Chr &at(const ParserBAM::Data &x)
+        {
+            if (x.tid() < 0)
+            {
+                return _none;
+            }
+            else if (static_cast<std::size_t>(x.tid()) >= _data.size())
+            {
+                _data.resize(x.tid() + 1);
+            }
+        
+            auto &c = _data[x.tid()];
+        
+            if (!c.init)
+            {
+                const auto &cID = x.cID;
+            
+                c.init = true;
+                c.isChrIS = isChrIS(cID);
+            
+                if (_stats.data.count(cID))
+                {
+                    c.data = &_stats.data.at(cID);
+                    c.e = &_stats.eInters.at(cID);
+                    c.i = &_stats.iInters.at(cID);
+                
+                    if (_sorted)
+                    {
+                        c.se = std::make_shared<SweepIntervals<MergedInterval>>(_stats.eInters.at(cID));
+                        c.si = std::make_shared<SweepIntervals<MergedInterval>>(_stats.iInters.at(cID));
+                    }
+                }
+            }
+        
+            return c;
+        }
+
+    private:
+    
+        RAlign::Stats &_stats;
+    
+        const bool _sorted;
+    
+        std::vector<Chr> _data;
+    
+        // Alignments without coordinate
+        Chr _none;
+};
+
+static void match(const ParserBAM::Info &info, ParserBAM::Data &align, Chrs::Chr &c)
+{
+    Locus l;
+    bool spliced;
+
+    if (!c.data)
     {
         throw std::runtime_error("Chromsome: [" + align.cID + "] can't be found in annotations");
     }
     
-    auto &x = stats.data.at(align.cID);
+    auto &x = *c.data;
+
+    const auto se = c.se.get();
+    const auto si = c.si.get();
+
+    if (se)
+    {
+        se->advance(align.l.start);
+        si->advance(align.l.start);
+    }
 
     if (info.skip)
     {
@@ -229,7 +318,7 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
     // This'll be set to false whenever there is a mismatch
     bool isTP = true;
     
-    GeneID gID = "";
+    const GeneID *gID = nullptr;
 
     // Check all cigar blocks...
     while (align.nextCigar(l, spliced))
@@ -237,12 +326,12 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
         if (spliced)
         {
             // Can we find an exact match for the intron?
-            auto match = stats.iInters.at(align.cID).exact(l);
+            auto match = si ? si->exact(l) : c.i->firstExact(l);
             
             if (match)
             {
                 // We'll use it to calculate sensitivty at the intron level
-                match->map(l);
+                match->add(l);
 
                 writeIntron(align.cID, l, match->gID(), "TP");
             }
@@ -257,7 +346,7 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
         else
         {
             // Can we find an contained match for the exon?
-            const auto match = stats.eInters.at(align.cID).contains(l);
+            const auto match = se ? se->contains(l) : c.e->firstContains(l);
             
 #ifdef RALIGN_DEBUG
             if (ms.size() > 1)
@@ -270,27 +359,27 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
             if (match)
             {
                 // We'll need it for calculating sensitivity at the base level
-                match->map(l);
+                match->add(l);
                 
-                gID = match->gID();
+                gID = &match->gID();
 
                 writeBase(align.cID, l, "TP");
             }
             else
             {
                 // Can we find an overlapping match for the exon?
-                const auto match = stats.eInters.at(align.cID).overlap(l);
+                const auto match = se ? se->overlap(l) : c.e->firstOverlap(l);
 
                 if (match)
                 {
-                    match->map(l);
+                    match->add(l);
                     
                     // Gap to the left?
                     if (l.start < match->l().start)
                     {
                         const auto gap = Locus(l.start, match->l().start-1);
                         
-                        x.bLvl.fp->map(gap);
+                        x.bLvl.fp->add(gap);
                         
                         writeBase(align.cID, gap, "FP");
                     }
@@ -300,7 +389,7 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
                     {
                         const auto gap = Locus(match->l().end+1, l.end);
                         
-                        x.bLvl.fp->map(gap);
+                        x.bLvl.fp->add(gap);
                         
                         writeBase(align.cID, gap, "FP");
                     }
@@ -308,7 +397,7 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
                 else
                 {
                     // The entire locus is outside of the reference region
-                    x.bLvl.fp->map(l);
+                    x.bLvl.fp->add(l);
                     
                     writeBase(align.cID, l, "FPO");
                 }
@@ -323,8 +412,8 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
     {
         x.aLvl.m.tp()++;
 
-        A_CHECK(!gID.empty(), "!gID.empty()");
-        x.g2r[gID]++;
+        A_CHECK(gID && !gID->empty(), "!gID.empty()");
+        x.g2r[*gID]++;
     }
     else
     {
@@ -332,38 +421,332 @@ static void match(RAlign::Stats &stats, const ParserBAM::Info &info, ParserBAM::
     }
 }
 
-RAlign::Stats RAlign::analyze(const FileName &file, const Options &o)
+static void process(RAlign::Stats &stats, ParserBAM::Data &x, const ParserBAM::Info &info, Chrs &chrs)
 {
-    o.analyze(file);
+    auto &c = chrs.at(x);
+
+    // Don't count for multiple alignments
+    if (!x.mapped || x.isPrimary)
+    {
+#ifdef RALIGN_DEBUG
+        if (x.mapped && x.cID != ChrIS)
+            __rWriter__ << x.name << "\n";
+#endif
+        stats.update(x, [&](const ChrID &) { return c.isChrIS; });
+    }
+
+    if (!x.mapped)
+    {
+        return;
+    }
+    else if (c.isChrIS || c.data)
+    {
+        match(info, x, c);
+    }
+}
+
+/*
+ * Size of a region in the sharded mode. Large chromosomes are split into several regions
+ * so that the workload is balanced across the threads.
+ */
+
+#define SHARD_SIZE 10000000
+
+/*
+ * Reference intervals copied beyond the end of a region. A region with an alignment reaching
+ * further is parsed again with the intervals up to the end of the alignment.
+ */
+
+#define SHARD_SPAN 10000000
+
+// Alignment reaching beyond the intervals copied for its region
+struct Beyond
+{
+    Base end;
+};
+
+// Reference intervals for a chromosome sorted by position, copied for the regions
+struct Template
+{
+    std::vector<MergedInterval> e, i;
+};
+
+static Template sortedInters(const RAlign::Stats &stats, const ChrID &cID)
+{
+    Template t;
     
-    return calculate(o, [&](RAlign::Stats &stats)
+    auto sorted = [&](std::vector<MergedInterval> &dst, const MergedIntervals<> &src)
     {
-        ParserBAM::parse(file, [&](ParserBAM::Data &x, const ParserBAM::Info &info)
+        for (const auto &i : src.data())
         {
-            if (info.p.i && !(info.p.i % 1000000))
+            dst.push_back(i.second);
+        }
+        
+        std::sort(dst.begin(), dst.end(), [&](const MergedInterval &x, const MergedInterval &y)
+        {
+            return x.l().start < y.l().start;
+        });
+    };
+    
+    sorted(t.e, stats.eInters.at(cID));
+    sorted(t.i, stats.iInters.at(cID));
+
+    return t;
+}
+
+/*
+ * Empty statistics for a worker, with its own copy of the reference intervals overlapping
+ * the region, up to the given span beyond the region. The intervals are not indexed, the
+ * alignments are sorted thus matched by the sweep-line.
+ */
+
+static RAlign::Stats shard(const Template &t, const ChrID &cID, const Locus &l, Base span)
+{
+    RAlign::Stats x;
+    
+    MergedInterval *mi = new MergedInterval(cID, Locus(1, std::numeric_limits<Base>::max()));
+    x.data[cID].bLvl.fp = std::shared_ptr<MergedInterval>(mi);
+
+    const auto end = l.end + span;
+    
+    auto copy = [&](MergedIntervals<> &dst, const std::vector<MergedInterval> &src)
+    {
+        for (const auto &i : src)
+        {
+            if (i.l().start > end)
             {
-                o.wait(std::to_string(info.p.i));
+                break;
             }
+            else if (i.l().end >= l.start)
+            {
+                dst.add(i);
+            }
+        }
+    };
+
+    copy(x.eInters[cID], t.e);
+    copy(x.iInters[cID], t.i);
+    
+    return x;
+}
 
-            // Don't count for multiple alignments
-            if (!x.mapped || x.isPrimary)
+// Merge statistics from a worker
+static void reduce(RAlign::Stats &stats, const RAlign::Stats &x)
+{
+    stats.nNA   += x.nNA;
+    stats.nEndo += x.nEndo;
+    stats.nSeqs += x.nSeqs;
+    
+    auto merge = [&](MergedIntervals<> &dst, const MergedIntervals<> &src)
+    {
+        for (const auto &i : src.data())
+        {
+            for (const auto &j : i.second.runs())
             {
-#ifdef RALIGN_DEBUG
-                if (x.mapped && x.cID != ChrIS)
-                    __rWriter__ << x.name << "\n";
-#endif
-                stats.update(x, isChrIS);
+                dst.find(i.first)->add(j);
             }
+        }
+    };
 
-            if (!x.mapped)
+    for (const auto &i : x.data)
+    {
+        const auto &cID = i.first;
+        const auto &src = i.second;
+        
+        auto &dst = stats.data.at(cID);
+        
+        dst.aLvl.normal  += src.aLvl.normal;
+        dst.aLvl.spliced += src.aLvl.spliced;
+        dst.aLvl.m.tp()  += src.aLvl.m.tp();
+        dst.aLvl.m.fp()  += src.aLvl.m.fp();
+        
+        dst.iLvl.fp.insert(src.iLvl.fp.begin(), src.iLvl.fp.end());
+        
+        for (const auto &j : src.g2r)
+        {
+            dst.g2r[j.first] += j.second;
+        }
+        
+        for (const auto &j : src.bLvl.fp->runs())
+        {
+            dst.bLvl.fp->add(j);
+        }
+        
+        merge(stats.eInters.at(cID), x.eInters.at(cID));
+        merge(stats.iInters.at(cID), x.iInters.at(cID));
+    }
+}
+
+/*
+ * Regions are analyzed independently by the worker threads. This is only possible for an
+ * indexed (thus sorted) alignment file. Each alignment is given by exactly one region.
+ */
+
+static void sharded(RAlign::Stats &stats, const FileName &file, const RAlign::Options &o)
+{
+    typedef std::pair<ChrID, Locus> Region;
+    
+    std::vector<Region> regions;
+    
+    for (const auto &i : ParserBAM::header(file))
+    {
+        for (Base j = 1; j <= i.second; j += SHARD_SIZE)
+        {
+            regions.push_back(Region(i.first, Locus(j, std::min(i.second, j + SHARD_SIZE - 1))));
+        }
+    }
+    
+    // Unmapped alignments without coordinate
+    regions.push_back(Region("*", Locus(0, 0)));
+    
+    o.info("Regions: " + std::to_string(regions.size()));
+
+    /*
+     * The workers can't copy from the statistics directly, because they're being reduced
+     * at the same time. Each chromosome is sorted once here and left untouched.
+     */
+    
+    std::map<ChrID, Template> temps;
+    
+    for (const auto &i : stats.data)
+    {
+        temps[i.first] = sortedInters(stats, i.first);
+    }
+
+    std::vector<std::future<RAlign::Stats>> futures;
+    
+    // The file and index are opened once for each worker
+    std::vector<std::shared_ptr<ParserBAM::Indexed>> readers(o.thr);
+    
+    // Declared last, the queued tasks are completed before anything they use is destroyed
+    ctpl::thread_pool pool(o.thr);
+
+    for (const auto &i : regions)
+    {
+        futures.push_back(pool.push([&, i](int id)
+        {
+            if (!readers[id])
             {
-                return;
+                readers[id] = std::make_shared<ParserBAM::Indexed>(file);
             }
-            else if (isChrIS(x.cID) || stats.data.count(x.cID))
+
+            const auto t = temps.count(i.first) ? &temps.at(i.first) : nullptr;
+
+            for (Base span = SHARD_SPAN;;)
             {
-                match(stats, info, x);
+                auto x = t ? shard(*t, i.first, i.second, span) : RAlign::Stats();
+
+                // The file is indexed, thus sorted
+                Chrs chrs(x, true);
+                
+                try
+                {
+                    readers[id]->parse(i.first, i.second, [&](ParserBAM::Data &align, const ParserBAM::Info &info)
+                    {
+                        if (t && align.mapped && info.end > i.second.end + span)
+                        {
+                            throw Beyond { info.end };
+                        }
+                        
+                        process(x, align, info, chrs);
+                    });
+                    
+                    return x;
+                }
+                catch (const Beyond &b)
+                {
+                    span = b.end - i.second.end;
+                }
             }
-        });
+        }));
+    }
+    
+    // Reduction in the order of the regions
+    for (std::size_t i = 0; i < futures.size(); i++)
+    {
+        reduce(stats, futures[i].get());
+        
+        if (regions[i].first != "*")
+        {
+            o.logWait(regions[i].first + ":" + std::to_string(regions[i].second.start) + "-" + std::to_string(regions[i].second.end));
+        }
+    }
+}
+
+/*
+ * Only alignments to the synthetic chromosome are fetched by the index. Alignments to the
+ * genome are never decoded, they're counted by the index statistics. The counts are only
+ * needed for dilution.
+ */
+
+static void synthetic(RAlign::Stats &stats, const FileName &file, const RAlign::Options &o)
+{
+    if (!ParserBAM::indexed(file))
+    {
+        throw std::runtime_error("Index (.bai or .csi) is required for -synOnly. Please index " + file + " and try again.");
+    }
+
+    for (const auto &i : ParserBAM::indexStats(file))
+    {
+        if (isChrIS(i.first))
+        {
+            const auto nSeqs = stats.nSeqs;
+            
+            Chrs chrs(stats, true);
+            
+            ParserBAM::parse(file, i.first, Locus(1, std::numeric_limits<int>::max()), [&](ParserBAM::Data &x, const ParserBAM::Info &info)
+            {
+                process(stats, x, info, chrs);
+            });
+            
+            // Counted the same way as the genome, otherwise the dilution would be biased
+            stats.nSeqs = nSeqs + i.second.mapped;
+        }
+        else
+        {
+            stats.nNA   += i.second.unmapped;
+            stats.nEndo += i.second.mapped;
+        }
+    }
+    
+    o.info("Alignments counted by the index (secondary and supplementary alignments included)");
+}
+
+RAlign::Stats RAlign::analyze(const FileName &file, const Options &o)
+{
+    o.analyze(file);
+    
+    return calculate(o, [&](RAlign::Stats &stats)
+    {
+        if (o.synOnly)
+        {
+            synthetic(stats, file, o);
+            return;
+        }
+
+        if (o.thr > 1 && ParserBAM::indexed(file))
+        {
+            o.info("Index found. Sharded analysis with " + std::to_string(o.thr) + " threads");
+            sharded(stats, file, o);
+            return;
+        }
+
+        // Reference intervals are looked up by the tree if the alignments are unsorted
+        const auto sorted = ParserBAM::sorted(file);
+        
+        o.info(sorted ? "Sorted by coordinate. Sweep-line matching." : "Not sorted by coordinate. Interval tree matching.");
+
+        Chrs chrs(stats, sorted);
+        
+        ParserBAM::parse(file, [&](ParserBAM::Data &x, const ParserBAM::Info &info)
+        {
+            if (info.p.i && !(info.p.i % 1000000))
+            {
+                o.wait(std::to_string(info.p.i));
+            }
+
+            process(stats, x, info, chrs);
+        }, false, o.thr);
     });
 }
 
@@ -375,7 +758,7 @@ static Scripts summary()
            "-------Number of alignments mapped to the synthetic chromosome and genome\n\n"
            "       Synthetic: %3%\n"
            "       Genome:    %4%\n"
-           "       Dilution:  %5$.3f\n\n"
+           "       Dilution:  %5$.3f\n%21%\n"
            "-------Reference annotation (Synthetic)\n\n"
            "       Synthetic: %7% exons\n"
            "       Synthetic: %8% introns\n"
@@ -413,7 +796,7 @@ static void generateSummary(const FileName &file,
     // Anaquin can only handle either "chrIS" or "IS"
     const auto chrIS = stats.data.count("chrIS") ? "chrIS" : "IS";
 
-    #define G(x) (stats.data.size() > 1   ? toString(x) : "-")
+    #define G(x) (stats.data.size() > 1 && !o.synOnly ? toString(x) : "-")
     #define S(x) (stats.data.count(chrIS) ? toString(x) : "-")
     
     o.writer->open(file);
@@ -437,6 +820,7 @@ static void generateSummary(const FileName &file,
                                               % S(stats.sim.pc())       // 18
                                               % S(stats.sbm.sn())       // 19
                                               % S(stats.sbm.pc())       // 20
+                                              % (o.synOnly ? "       *Counted by the index (secondary and supplementary alignments included)\n" : "") // 21
                      ).str());
     o.writer->close();
 }
@@ -458,9 +842,9 @@ static void writeBQuins(const FileName &file,
         
         for (const auto &j : stats.eInters.at(cID).data())
         {
-            for (const auto &k : j.second._data)
+            for (const auto &k : j.second.runs())
             {
-                const auto pos = (toString(k.second.start) + "-" + toString(k.second.end));
+                const auto pos = (toString(k.start) + "-" + toString(k.end));
                 o.writer->write((boost::format(format) % cID % pos % "TP").str());
             }
         }
@@ -598,7 +982,7 @@ static void writeQuins(const FileName &file,
                 bm[gID].fn() += bs.length - bs.nonZeros;
             }
             
-            const auto inters = gtf->gIntervals();
+            const auto &inters = gtf->gIntervals(cID);
             
             // For every gene in the reference
             for (const auto &gID : gtf->genes(cID))
@@ -611,11 +995,8 @@ static void writeQuins(const FileName &file,
                 // Sensitivity at the intron level
                 const auto isn = im.count(gID) ? std::to_string(im.at(gID).sn()) : "-";
                 
-                // Anaquin can only handle either "chrIS" or "IS"
-                const auto chrIS = inters.count("chrIS") ? "chrIS" : "IS";
-                
                 o.writer->write((boost::format(format) % gID
-                                                       % inters.at(chrIS).find(gID)->l().length()
+                                                       % inters.find(gID)->l().length()
                                                        % reads
                                                        % isn
                                                        % bm.at(gID).sn()).str());
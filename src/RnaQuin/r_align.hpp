@@ -15,7 +15,13 @@ namespace Anaquin
     {
         public:
 
-            typedef AnalyzerOptions Options;
+            struct Options : public AnalyzerOptions
+            {
+                Options() {}
+
+                // Only the synthetic chromosome is analyzed, requires an index (-synOnly)
+                bool synOnly = false;
+            };
 
             struct Stats : public AlignmentStats
             {
@@ -1,3 +1,4 @@
+#include <deque>
 #include <thread>
 #include <fstream>
 #include "tools/system.hpp"
@@ -5,16 +6,13 @@
 #include "tools/gtf_data.hpp"
 #include "RnaQuin/RnaQuin.hpp"
 #include "RnaQuin/r_assembly.hpp"
+#include "cufflinks/cuffcompare.h"
 
 using namespace Anaquin;
 
-// Defined for cuffcompare
-Compare __cmp__;
-
-static FileName __QForSyn__;
-static FileName __QForGen__;
-static FileName __RForSyn__;
-static FileName __RForGen__;
+// Query and reference records for the synthetic and the genome
+static ParserGTF::Split __QSplit__;
+static ParserGTF::Split __RSplit__;
 
 static GTFData __RData__;
 static RAssembly::Stats *__Stats__;
@@ -24,83 +22,17 @@ static bool __hasGen__;
 // Defined in resources.cpp
 extern FileName GTFRef();
 
-// Defined for Cuffcompare
-extern int cuffcompare_main(const char *ref, const char *query);
-
-static std::string exec(const char* cmd)
-{
-    char buffer[128];
-    std::string result = "";
-    std::shared_ptr<FILE> pipe(popen(cmd, "r"), pclose);
-    if (!pipe) throw std::runtime_error("popen() failed!");
-    while (!feof(pipe.get())) {
-        if (fgets(buffer, 128, pipe.get()) != NULL)
-            result += buffer;
-    }
-    
-    return result;
-}
-
-static FileName grepGTF(const FileName &file, const std::string &key, bool shouldGeneTrans = true)
-{
-    const auto tmp = System::tmpFile();
-    assert(!key.empty());
-    
-    std::string cmd;
-    
-    if (shouldGeneTrans)
-    {
-        cmd = "grep " + key + " " + file + " > " + tmp;
-    }
-    else
-    {
-        cmd = "grep " + key + " " + file + " | grep -v gene_type | grep -v transcript_type > " + tmp;
-    }
-    
-    const auto msg = exec(cmd.c_str());
-    
-    if (!msg.empty())
-    {
-        A_THROW("Failed to execute: " + msg);
-    }
-
-    return tmp;
-}
-
-static FileName grepVGTF(const FileName &file, const std::string &key)
-{
-    const auto tmp = System::tmpFile();
-    const auto cmd = "grep -v " + key + " " + file + " > " + tmp;
-    const auto msg = exec(cmd.c_str());
-    
-    if (!msg.empty())
-    {
-        A_THROW("Failed to execute: " + msg);
-    }
-    
-    return tmp;
-}
-
 static ChrID __ChrIS__;
 
-static FileName createQGTFSyn(const FileName &file)
-{
-    return (__QForSyn__ = grepGTF(file, __ChrIS__));
-}
-
-static FileName createQGTFGen(const FileName &file)
-{
-    return (__QForGen__ = grepVGTF(file, __ChrIS__));
-}
-
-static FileName createRGTFSyn(const FileName &file)
+static void splitQueryGTF(const FileName &file)
 {
-    return (__RForSyn__ = grepGTF(file, __ChrIS__, false));
+    __QSplit__ = ParserGTF::split(Reader(file), __ChrIS__);
 }
 
-static FileName createRGTFGen(const FileName &file)
+static void splitRefGTF(const FileName &file)
 {
-    return (__RForGen__ = grepVGTF(file, __ChrIS__));
+    // Gene and transcript records with types don't work with Cuffcompare
+    __RSplit__ = ParserGTF::split(Reader(file), __ChrIS__, { "gene_type", "transcript_type" });
 }
 
 static void readQueryGTF(const FileName &file)
@@ -122,6 +54,67 @@ static void readRefGTF(const FileName &file)
     __RData__ = gtfData(Reader(file));
 }
 
+/*
+ * Worker threads, joined however the analysis is left. An exception of a worker is kept for
+ * the caller, it'd terminate the program otherwise.
+ */
+
+struct Workers
+{
+    ~Workers() { wait(); }
+
+    template <typename F> void run(F f)
+    {
+        errs.push_back(nullptr);
+        
+        auto &err = errs.back();
+        
+        ts.push_back(std::thread([&err, f]()
+        {
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                err = std::current_exception();
+            }
+        }));
+    }
+    
+    inline void wait()
+    {
+        for (auto &t : ts)
+        {
+            if (t.joinable())
+            {
+                t.join();
+            }
+        }
+    }
+
+    // Wait for all workers, the first exception is thrown
+    inline void join()
+    {
+        wait();
+        
+        for (auto &err : errs)
+        {
+            if (err)
+            {
+                const auto x = err;
+                err = nullptr;
+                std::rethrow_exception(x);
+            }
+        }
+    }
+    
+    std::vector<std::thread> ts;
+    
+    // Stable for the workers
+    std::deque<std::exception_ptr> errs;
+};
+
 static RAssembly::Stats init(const RAssembly::Options &o)
 {
     const auto &r = Standard::instance().r_rna;
@@ -147,140 +140,128 @@ RAssembly::Stats RAssembly::analyze(const FileName &file, const Options &o)
      * Filtering transcripts
      */
     
-    auto copyStats = [&](const ChrID &cID)
+    // Percentage to a fraction, NAN (can't be computed, eg: introns for no intron) is kept
+    auto frac = [](double x)
+    {
+        return std::isnan(x) ? x : std::min(x / 100.0, 1.0);
+    };
+
+    auto copyStats = [&](const ChrID &cID, const Compare &x)
     {
-        stats.data[cID].eSN  = std::min(__cmp__.e_sn  / 100.0, 1.0);
-        stats.data[cID].eSP  = std::min(__cmp__.e_sp  / 100.0, 1.0);
-        stats.data[cID].eFSN = std::min(__cmp__.e_fsn / 100.0, 1.0);
-        stats.data[cID].eFSP = std::min(__cmp__.e_fsp / 100.0, 1.0);
-
-        stats.data[cID].iSN  = std::min(__cmp__.i_sn  / 100.0, 1.0);
-        stats.data[cID].iSP  = std::min(__cmp__.i_sp  / 100.0, 1.0);
-        stats.data[cID].iFSN = std::min(__cmp__.i_fsn / 100.0, 1.0);
-        stats.data[cID].iFSP = std::min(__cmp__.i_fsp / 100.0, 1.0);
-
-        stats.data[cID].cSN  = std::min(__cmp__.c_sn  / 100.0, 1.0);
-        stats.data[cID].cSP  = std::min(__cmp__.c_sp  / 100.0, 1.0);
-        stats.data[cID].cFSN = std::min(__cmp__.c_fsn / 100.0, 1.0);
-        stats.data[cID].cFSP = std::min(__cmp__.c_fsp / 100.0, 1.0);
+        stats.data[cID].eSN  = frac(x.e_sn);
+        stats.data[cID].eSP  = frac(x.e_sp);
+        stats.data[cID].eFSN = frac(x.e_fsn);
+        stats.data[cID].eFSP = frac(x.e_fsp);
+
+        stats.data[cID].iSN  = frac(x.i_sn);
+        stats.data[cID].iSP  = frac(x.i_sp);
+        stats.data[cID].iFSN = frac(x.i_fsn);
+        stats.data[cID].iFSP = frac(x.i_fsp);
+
+        stats.data[cID].cSN  = frac(x.c_sn);
+        stats.data[cID].cSP  = frac(x.c_sp);
+        stats.data[cID].cFSN = frac(x.c_fsn);
+        stats.data[cID].cFSP = frac(x.c_fsp);
         
-        stats.data[cID].tSN  = std::min(__cmp__.t_sn  / 100.0, 1.0);
-        stats.data[cID].tSP  = std::min(__cmp__.t_sp  / 100.0, 1.0);
-        stats.data[cID].tFSN = std::min(__cmp__.t_fsn / 100.0, 1.0);
-        stats.data[cID].tFSP = std::min(__cmp__.t_fsp / 100.0, 1.0);
+        stats.data[cID].tSN  = frac(x.t_sn);
+        stats.data[cID].tSP  = frac(x.t_sp);
+        stats.data[cID].tFSN = frac(x.t_fsn);
+        stats.data[cID].tFSP = frac(x.t_fsp);
         
-        stats.data[cID].bSN  = std::min(__cmp__.b_sn  / 100.0, 1.0);
-        stats.data[cID].bSP  = std::min(__cmp__.b_sp  / 100.0, 1.0);
-
-        stats.data[cID].mExonN    = __cmp__.missedExonsN;
-        stats.data[cID].mExonR    = __cmp__.missedExonsR;
-        stats.data[cID].mExonP    = __cmp__.missedExonsP / 100.0;
-        stats.data[cID].mIntronN  = __cmp__.missedIntronsN;
-        stats.data[cID].mIntronR  = __cmp__.missedIntronsR;
-        stats.data[cID].mIntronP  = __cmp__.missedIntronsP / 100.0;
-
-        stats.data[cID].nExonN    = __cmp__.novelExonsN;
-        stats.data[cID].nExonR    = __cmp__.novelExonsR;
-        stats.data[cID].nExonP    = __cmp__.novelExonsP / 100.0;
-        stats.data[cID].nIntronN  = __cmp__.novelIntronsN;
-        stats.data[cID].nIntronR  = __cmp__.novelIntronsR;
-        stats.data[cID].nIntronP  = __cmp__.novelIntronsP / 100.0;
+        stats.data[cID].bSN  = frac(x.b_sn);
+        stats.data[cID].bSP  = frac(x.b_sp);
+
+        stats.data[cID].mExonN    = x.missedExonsN;
+        stats.data[cID].mExonR    = x.missedExonsR;
+        stats.data[cID].mExonP    = x.missedExonsP / 100.0;
+        stats.data[cID].mIntronN  = x.missedIntronsN;
+        stats.data[cID].mIntronR  = x.missedIntronsR;
+        stats.data[cID].mIntronP  = x.missedIntronsP / 100.0;
+
+        stats.data[cID].nExonN    = x.novelExonsN;
+        stats.data[cID].nExonR    = x.novelExonsR;
+        stats.data[cID].nExonP    = x.novelExonsP / 100.0;
+        stats.data[cID].nIntronN  = x.novelIntronsN;
+        stats.data[cID].nIntronR  = x.novelIntronsR;
+        stats.data[cID].nIntronP  = x.novelIntronsP / 100.0;
     };
     
-    auto compareGTF = [&](const ChrID &cID, const FileName &ref, const FileName &qry)
+    auto compareGTF = [&](const std::string &ref, const std::string &qry) -> Compare
     {
-        o.logInfo("Reference: " + ref);
-        o.logInfo("Query: " + qry);
-        
-        #define CUFFCOMPARE(x, y) { if (cuffcompare_main(x.c_str(), y.c_str())) { throw std::runtime_error("Failed to analyze " + file + ". Please check the file and try again."); } }
-
-        // Only required for sensitivity at individual sequins...
-        if (isChrIS(cID))
+        try
         {
-            /*
-             * Calculate sensitivty for each sequin. Unfortunately, there is no simpler way
-             * than Cuffcompare. Cuffcompare doesn't show sensitivity for each isoforms,
-             * thus we'll need to generate a GTF file for each sequin.
-             */
-
-            for (const auto &i : r.seqsL1())
-            {
-                // Generate a new reference GTF solely for the sequins
-                const auto tmp = grepGTF(ref, i);
-                
-                o.analyze(i);
-                
-                // Compare only the sequin against the reference
-                CUFFCOMPARE(tmp, qry);
-                
-                stats.tSPs[i] = __cmp__.b_sn;
-            }
+            CuffData rData, qData;
+            cuffParseRef(rData, ref, GTFRef().c_str());
+            cuffParseQry(qData, qry, file.c_str(), rData);
+            return CuffCompare().compare(rData, qData);
+        }
+        catch (const std::exception &ex)
+        {
+            throw std::runtime_error("Failed to analyze " + file + " (" + ex.what() + "). Please check the file and try again.");
         }
-
-        // Compare everything about the chromosome against the reference
-        CUFFCOMPARE(ref, qry);
-
-        o.logInfo("Compare complated");
     };
 
-    std::thread t1(readQueryGTF, file);
-    std::thread t2(readRefGTF, GTFRef());
+    Workers t12;
+    t12.run([&]() { readQueryGTF(file);  });
+    t12.run([&]() { readRefGTF(GTFRef()); });
 
     /*
-     * Create a new synthetic-only GTF file, which we'll use to estimate sequin sensitivity
+     * Split the records for the synthetic and the genome, they're compared separately
      */
 
     o.info("Analyzing transcripts");
-    o.info("Creating temporary transcripts");
+    o.info("Splitting transcripts");
     
     // Only "chrIS" and "IS" are supported
     __ChrIS__ = stats.data.count("chrIS") ? "chrIS" : "IS";
     
-    std::thread t3(createQGTFSyn, file);
-    std::thread t4(createQGTFGen, file);
-    std::thread t5(createRGTFSyn, GTFRef());
-    std::thread t6(createRGTFGen, GTFRef());
-
-    t3.join();
-    t4.join();
-    t5.join();
-    t6.join();
-    
-    o.logInfo(__QForSyn__);
-    o.logInfo(__QForGen__);
-    o.logInfo(__RForSyn__);
-    o.logInfo(__RForGen__);
+    Workers t34;
+    t34.run([&]() { splitQueryGTF(file);  });
+    t34.run([&]() { splitRefGTF(GTFRef()); });
+    t34.join();
     
-    A_CHECK(!__QForSyn__.empty(), "Error in __QForSyn__");
-    A_CHECK(!__QForGen__.empty(), "Error in __QForGen__");
-    A_CHECK(!__RForSyn__.empty(), "Error in __RForSyn__");
-    A_CHECK(!__RForGen__.empty(), "Error in __RForGen__");
-    
-    o.info("Temporary transcripts generated");
+    o.info("Transcripts split");
+
+    __hasGen__ = !__QSplit__.rest.empty();
 
     /*
-     * Comparing for the synthetic
+     * Comparing for the synthetic and the genome. They share nothing, thus the genome is compared
+     * on a separate thread.
      */
 
+    Compare sCmp, gCmp;
+
     o.info("Generating for the synthetic");
-    compareGTF(__ChrIS__, __RForSyn__, __QForSyn__);
-    copyStats(__ChrIS__);
-    
-    /*
-     * Comparing for the genome
-     */
 
-    if ((__hasGen__ = !System::isEmpty(__QForGen__)))
+    Workers t7;
+
+    if (__hasGen__)
     {
         o.analyze("Genome");
-        compareGTF("endo", __RForGen__, __QForGen__);
-        copyStats("endo");
+        t7.run([&]() { gCmp = compareGTF(__RSplit__.rest, __QSplit__.rest); });
+    }
+
+    sCmp = compareGTF(__RSplit__.chr, __QSplit__.chr);
+    t7.join();
+
+    o.logInfo("Compare complated");
+
+    copyStats(__ChrIS__, sCmp);
+
+    // Cuffcompare gives base sensitivity for each reference transcript in the same pass
+    for (const auto &i : r.seqsL1())
+    {
+        stats.tSPs[i] = sCmp.t_bsn.count(i) ? sCmp.t_bsn.at(i) : NAN;
+    }
+
+    if (__hasGen__)
+    {
+        copyStats("endo", gCmp);
     }
     
     o.info("Waiting for worker threads to complete");
 
-    t1.join();
-    t2.join();
+    t12.join();
     
     A_CHECK(stats.sExons, "stats.sExons");
 
@@ -317,7 +298,7 @@ static void writeSummary(const FileName &file, const RAssembly::Stats &stats, co
     const auto gData  = hasGen ? stats.data.at("endo") : RAssembly::Stats::Data();
 
     #define C(x) (std::to_string(x))
-    #define S(x) (x == 1.0 ? "1.00" : std::to_string(x))
+    #define S(x) (std::isnan(x) ? "-" : x == 1.0 ? "1.00" : std::to_string(x))
     
     const auto format = "-------RnaAssembly Summary Statistics\n\n"
                         "       User assembly file: %1%\n"
@@ -1,4 +1,5 @@
 #include <cmath>
+#include "tools/ctpl_stl.h"
 #include "RnaQuin/r_express.hpp"
 #include "parsers/parser_gtf.hpp"
 #include "parsers/parser_express.hpp"
@@ -190,7 +191,7 @@ RExpress::Stats RExpress::analyze(const FileName &file, const Options &o)
         {
             ParserExpress::Data t;
             
-            ParserGTF::parse(file, [&](const ParserGTF::Data &x, const std::string &, const ParserProgress &p)
+            ParserGTF::parse(file, [&](const ParserGTF::Data &x, const LineView &, const ParserProgress &p)
             {
                 if (p.i && !(p.i % 100000))
                 {
@@ -243,6 +244,80 @@ RExpress::Stats RExpress::analyze(const FileName &file, const Options &o)
     return stats;
 }
 
+// Messages of a worker, held until the file is done
+struct BufferWriter : public Writer<>
+{
+    inline void close() override {}
+    inline void open(const FileName &) override {}
+    inline void write(const std::string &x) override { lines.push_back(x); }
+
+    std::vector<std::string> lines;
+};
+
+static void checkStats(const FileName &file, const RExpress::Stats &x)
+{
+    if (x.genes.empty() && x.isos.empty())
+    {
+        throw std::runtime_error("Failed to find anything on the in-silico chromosome: " + file);
+    }
+}
+
+std::vector<RExpress::Stats> RExpress::analyze(const std::vector<FileName> &files, const Options &o)
+{
+    std::vector<RExpress::Stats> stats;
+    
+    if (o.thr <= 1 || files.size() <= 1)
+    {
+        for (const auto &file : files)
+        {
+            stats.push_back(analyze(file, o));
+            checkStats(file, stats.back());
+        }
+        
+        return stats;
+    }
+
+    /*
+     * Each replicate is parsed and matched by a worker. The standard is only read. Messages
+     * are replayed in the order of the files, thus the log reads as if the files were
+     * analyzed one after another.
+     */
+
+    std::vector<Options> opts(files.size(), o);
+    std::vector<std::shared_ptr<BufferWriter>> logs, outs;
+    
+    ctpl::thread_pool pool(std::min<std::size_t>(o.thr, files.size()));
+    std::vector<std::future<RExpress::Stats>> futures;
+    
+    for (std::size_t i = 0; i < files.size(); i++)
+    {
+        logs.push_back(std::make_shared<BufferWriter>());
+        outs.push_back(std::make_shared<BufferWriter>());
+        
+        opts[i].logger = logs[i];
+        opts[i].output = outs[i];
+        
+        futures.push_back(pool.push([&, i](int)
+        {
+            return analyze(files[i], opts[i]);
+        }));
+    }
+    
+    for (std::size_t i = 0; i < futures.size(); i++)
+    {
+        futures[i].wait();
+        
+        for (const auto &j : logs[i]->lines) { o.logger->write(j); }
+        for (const auto &j : outs[i]->lines) { o.output->write(j); }
+
+        // The first error in the order of the files
+        stats.push_back(futures[i].get());
+        checkStats(files[i], stats.back());
+    }
+    
+    return stats;
+}
+
 static Scripts multipleTSV(const std::vector<RExpress::Stats> &stats, bool shouldIso)
 {
     const auto &r = Standard::instance().r_rna;
@@ -64,24 +64,8 @@ namespace Anaquin
 
         static Stats analyze(const FileName &, const Options &o);
 
-        static std::vector<Stats> analyze(const std::vector<FileName> &files, const Options &o)
-        {
-            std::vector<RExpress::Stats> stats;
-            
-            for (const auto &file : files)
-            {
-                const auto x = analyze(file, o);
-                
-                if (x.genes.empty() && x.isos.empty())
-                {
-                    throw std::runtime_error("Failed to find anything on the in-silico chromosome: " + file);
-                }
-
-                stats.push_back(x);
-            }
-
-            return stats;
-        }
+        // Replicates are analyzed concurrently (-threads), the results are in the order of the files
+        static std::vector<Stats> analyze(const std::vector<FileName> &, const Options &o);
 
         static Scripts generateITSV(const std::vector<RExpress::Stats> &, const Options &);
         static Scripts generateGTSV(const std::vector<RExpress::Stats> &, const Options &);
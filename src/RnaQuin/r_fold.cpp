@@ -81,7 +81,7 @@ template <typename T> void classify(RFold::Stats &stats, const T &t, Metrics met
         {
             assert(!t.iID.empty());
             
-            if (r.seqsL1().count(t.iID))
+            if (r.namesL1().count(t.iID))
             {
                 f(t.iID, r.input5(t.iID));
             }
@@ -97,7 +97,7 @@ template <typename T> void classify(RFold::Stats &stats, const T &t, Metrics met
         {
             assert(!t.gID.empty());
             
-            if (r.seqsL2().count(t.gID))
+            if (r.namesL2().count(t.gID))
             {
                 f(t.gID, r.input6(t.gID));
             }
@@ -5,22 +5,36 @@
 
 using namespace Anaquin;
 
-RSample::Stats RSample::stats(const FileName &file, const Options &o)
-{
-    A_CHECK(!std::isnan(o.p), "Sampling probability must not be NAN");
-    A_CHECK(o.p > 0 && o.p < 1.0, "Sampling probability must be (0:1)");
-
-    RSample::Stats stats;
-    
-    o.info(file);
-
-    o.info("Spike-in proportion: " + std::to_string(o.p));
+/*
+ * Nothing is parsed, both the in-silico chromosome and the genome are taken from the index statistics. They
+ * also count secondary and supplementary alignments, the same way on both sides so the ratio is not biased.
+ * The counts are only for the normalization (reported separately), the other counts in the summary are from
+ * the sampling pass.
+ */
 
-    /*
-     * Computing sequencing depth for both genomic and synthetic before subsampling
-     */
+static void countByIndex(RSample::Stats &stats, const FileName &file)
+{
+    for (const auto &i : ParserBAM::indexStats(file))
+    {
+        if (i.first == "*")
+        {
+            continue;
+        }
+        else if (isChrIS(i.first))
+        {
+            stats.before.syn += i.second.mapped;
+        }
+        else
+        {
+            stats.before.gen += i.second.mapped;
+        }
+    }
+}
 
-    o.info("Calculating the coverage before subsampling");
+static void countByParse(RSample::Stats &stats, const FileName &file, const RSample::Options &o)
+{
+    // Whether the chromosome is synthetic, for each chromosome in the header
+    std::vector<int> chrIS;
     
     ParserBAM::parse(file, [&](ParserBAM::Data &x, const ParserBAM::Info &info)
     {
@@ -32,7 +46,17 @@ RSample::Stats RSample::stats(const FileName &file, const Options &o)
         // Don't count for multiple alignments
         if (x.isPrimary && x.isAligned)
         {
-            if (isChrIS(x.cID))
+            if (x.tid() >= 0 && static_cast<std::size_t>(x.tid()) >= chrIS.size())
+            {
+                chrIS.resize(x.tid() + 1, -1);
+            }
+            
+            if (x.tid() >= 0 && chrIS[x.tid()] == -1)
+            {
+                chrIS[x.tid()] = isChrIS(x.cID);
+            }
+            
+            if (x.tid() >= 0 ? chrIS[x.tid()] : isChrIS(x.cID))
             {
                 stats.before.syn++;
             }
@@ -41,7 +65,35 @@ RSample::Stats RSample::stats(const FileName &file, const Options &o)
                 stats.before.gen++;
             }
         }
-    });
+    }, false, o.thr);
+}
+
+RSample::Stats RSample::stats(const FileName &file, const Options &o)
+{
+    A_CHECK(!std::isnan(o.p), "Sampling probability must not be NAN");
+    A_CHECK(o.p > 0 && o.p < 1.0, "Sampling probability must be (0:1)");
+
+    RSample::Stats stats;
+    
+    o.info(file);
+
+    o.info("Spike-in proportion: " + std::to_string(o.p));
+
+    /*
+     * Computing sequencing depth for both genomic and synthetic before subsampling
+     */
+
+    if (o.index && ParserBAM::indexed(file))
+    {
+        o.info("Calculating the coverage before subsampling by the index");
+        countByIndex(stats, file);
+        stats.byIndex = true;
+    }
+    else
+    {
+        o.info("Calculating the coverage before subsampling");
+        countByParse(stats, file, o);
+    }
 
     o.info("Alignments mapped to the in-silico (before subsampling): " + std::to_string(stats.before.syn));
     o.info("Alignments mapped to the genome (before subsampling): "    + std::to_string(stats.before.gen));
@@ -70,15 +122,19 @@ RSample::Stats RSample::stats(const FileName &file, const Options &o)
      */
     
     stats.norm = nSyn < stats.before.syn ? static_cast<Proportion>(nSyn) / stats.before.syn : 1.0;
+    stats.normSyn = stats.before.syn;
+    stats.normGen = stats.before.gen;
 
     o.logInfo("New Total: "     + std::to_string(nTotal));
     o.logInfo("New Synthetic: " + std::to_string(nSyn));
     o.info("Normalization: "    + std::to_string(stats.norm));
 
     // Perform subsampling
-    const auto r = Sampler::sample(file, stats.norm, o, [&](const ChrID &id) { return isChrIS(id); });
+    const auto r = Sampler::sample(file, stats.norm, o, [&](const ChrID &id) { return isChrIS(id); }, o.out, o.seed);
 
-    stats.after = r.after;
+    // Exact counts from the sampling pass (the same as the counting pass)
+    stats.before = r.before;
+    stats.after  = r.after;
 
     return stats;
 }
@@ -96,7 +152,9 @@ static void generateSummary(const FileName &file, const FileName &src, const RSa
                          "       * Dilution specified by the user:\n"
                          "       Fraction: %5%\n\n"
                          "       * Normalization applied in subsampling:\n"
-                         "       Normalization: %6%\n\n"
+                         "       Normalization: %6%\n"
+                         "       Synthetic:     %12% alignments%11%\n"
+                         "       Genome:        %10% alignments%11%\n\n"
                          "-------User alignments (after subsampling)\n\n"
                          "       Synthetic: %7% reads\n"
                          "       Genome:    %8% reads\n"
@@ -112,7 +170,10 @@ static void generateSummary(const FileName &file, const FileName &src, const RSa
                                             % stats.norm
                                             % stats.after.syn
                                             % stats.after.gen
-                                            % stats.after.dilut()).str());
+                                            % stats.after.dilut()
+                                            % stats.normGen
+                                            % (stats.byIndex ? " (by the index, secondary and supplementary alignments included)" : "")
+                                            % stats.normSyn).str());
     o.writer->close();
 }
 
@@ -14,6 +14,15 @@ namespace Anaquin
             
             // Fraction required for the spike-in
             Proportion p = NAN;
+
+            // Counting by the index rather than a full pass, if the alignment file is indexed
+            bool index = false;
+
+            // Random seed, the same seed gives the same alignments
+            Seed seed = 0;
+
+            // Output alignment file (BAM, CRAM or SAM), printed to the console if empty
+            FileName out;
         };
 
         struct Stats : public MappingStats
@@ -25,6 +34,12 @@ namespace Anaquin
 
             // Normalization factor
             Proportion norm;
+
+            // Whether the alignments were counted by the index for the normalization
+            bool byIndex = false;
+
+            // Alignments for the normalization, secondary and supplementary included if byIndex
+            Reads normSyn = 0, normGen = 0;
         };
 
         static Stats stats(const FileName &, const Options &o);
@@ -2,6 +2,7 @@
 #include <stdarg.h>
 #include <ctype.h>
 #include <sys/stat.h>
+#include <stdexcept>
 
 #ifndef S_ISDIR
 #define S_ISDIR(mode)  (((mode) & S_IFMT) == S_IFDIR)
@@ -58,28 +59,26 @@ void GAssert(const char* expression, const char* filename, unsigned int lineno){
   fprintf(stderr,"%s",msg);
   //abort();
   }
-// Error routine (prints error message and exits!)
+// Error routine (throws std::runtime_error with the message)
 void GError(const char* format,...){
-  #ifdef __WIN32__
     char msg[4096];
     va_list arguments;
     va_start(arguments,format);
-    vsprintf(msg,format,arguments);
+    vsnprintf(msg,sizeof(msg),format,arguments);
     va_end(arguments);
+  #ifdef __WIN32__
     OutputDebugString(msg);
-    fprintf(stderr,"%s",msg); // if a console is available
     MessageBox(NULL,msg,NULL,MB_OK|MB_ICONEXCLAMATION|MB_APPLMODAL);
-  #else
-    va_list arguments;
-    va_start(arguments,format);
-    vfprintf(stderr,format,arguments);
-    va_end(arguments);
-    #ifdef DEBUG
-     // modify here if you want a core dump
-     abort();
-    #endif
   #endif
-    exit(1);
+  #ifdef DEBUG
+    fprintf(stderr,"%s",msg);
+    // modify here if you want a core dump
+    abort();
+  #endif
+    //the caller decides if the error is fatal
+    int len=strlen(msg);
+    while (len>0 && msg[len-1]=='\n') msg[--len]=0;
+    throw std::runtime_error(msg);
   }
   
 // Warning routine (just print message without exiting)
@@ -203,7 +203,7 @@ void GFree(pointer* ptr); // Free memory, resets ptr to NULL
 
 //int saprintf(char **retp, const char *fmt, ...);
 
-void GError(const char* format,...); // Error routine (aborts program)
+void GError(const char* format,...); // Error routine (throws std::runtime_error)
 void GMessage(const char* format,...);// Log message to stderr
 // Assert failed routine:- usually not called directly but through GASSERT
 void GAssert(const char* expression, const char* filename, unsigned int lineno);
@@ -0,0 +1,75 @@
+#ifndef CUFFCOMPARE_H
+#define CUFFCOMPARE_H
+/*
+ *  cuffcompare.h
+ *
+ *  Accuracy of a set of transfrags against reference transcripts. Nothing is kept in globals,
+ *  separate comparisons can run concurrently.
+ *
+ *  All GffObj share the dictionary of names in GffObj::names, thus reading and releasing the
+ *  transcripts are serialised. Comparing doesn't touch the names. Both the reference and the
+ *  query are updated by a comparison, a reference can be reused by one comparison at a time,
+ *  a query can only be compared once.
+ */
+
+#include "gtf_tracking.h"
+#include "data/compare.hpp"
+
+struct CuffOptions {
+  bool reduceRefs; //-R: only reference transcripts overlapping any transfrags (Sn correction)
+  bool reduceQrys; //-Q: only transfrags overlapping any reference transcripts (Sp correction)
+  bool multiexon; //-M: discard single-exon transfrags and reference transcripts
+  bool multiexonRefs; //-N: discard single-exon reference transcripts
+  int discardRedundant; //1: discard intron-redundant transfrags, 2: not if sharing the 5' end (-F), 0: keep all (-G)
+  uint exonEndRange; //-e: distance allowed from free ends of terminal exons
+
+  CuffOptions():reduceRefs(false), reduceQrys(false), multiexon(false), multiexonRefs(false),
+                discardRedundant(1), exonEndRange(100) { }
+};
+
+//transcripts and loci for each genomic sequence
+class CuffData {
+ public:
+  GList<GSeqData> seqs; //sorted by gseq_id
+
+  CuffData():seqs(true,true,true) { }
+  CuffData(const CuffData&) = delete;
+  CuffData& operator=(const CuffData&) = delete;
+  ~CuffData();
+
+  //data for the genomic sequence, NULL if there is none
+  GSeqData* find(int gseq_id) { return getRefData(gseq_id, seqs); }
+};
+
+//read reference transcripts, throws std::runtime_error on errors
+void cuffReadRef(CuffData& ref, FILE* f, const char* fname, const CuffOptions& o=CuffOptions());
+void cuffReadRef(CuffData& ref, const char* fname, const CuffOptions& o=CuffOptions());
+
+//read transfrags, the reference orients the transfrags without strand
+void cuffReadQry(CuffData& qry, FILE* f, const char* fname, CuffData& ref, const CuffOptions& o=CuffOptions());
+void cuffReadQry(CuffData& qry, const char* fname, CuffData& ref, const CuffOptions& o=CuffOptions());
+
+//the same as above, but for GTF/GFF records in memory
+void cuffParseRef(CuffData& ref, const std::string& gff, const char* name, const CuffOptions& o=CuffOptions());
+void cuffParseQry(CuffData& qry, const std::string& gff, const char* name, CuffData& ref, const CuffOptions& o=CuffOptions());
+
+class CuffCompare {
+ public:
+  CuffCompare(const CuffOptions& o=CuffOptions()):opts(o), haveRefs(false) { }
+
+  //accuracy of the transfrags against the reference
+  Anaquin::Compare compare(CuffData& ref, CuffData& qry);
+
+ private:
+  CuffOptions opts;
+  bool haveRefs;
+  Anaquin::Compare res;
+
+  bool exon_match(GXSeg& r, GXSeg& q, uint fuzz=0);
+  void compareLoci2R(GList<GLocus>& loci, GList<GSuperLocus>& cmpdata, GList<GLocus>& refloci, int qfidx);
+  void processLoci(GSeqData& seqdata, GSeqData* refdata=NULL, int qfidx=0);
+  void collectStats(GSuperLocus& stats, GSeqData* seqdata, GSeqData* refdata);
+  void reportStats(GSuperLocus& stotal, GSeqData* seqdata=NULL, GSeqData* refdata=NULL);
+};
+
+#endif
@@ -578,13 +578,18 @@ int fix_umrnas(GSeqData& seqdata, GSeqData* rdata, FILE* fdis=NULL) {
 }
 
 //retrieve ref_data for a specific genomic sequence
+//(binary search on gseq_id, a GSeqData key would read GffObj::names)
 GSeqData* getRefData(int gid, GList<GSeqData>& ref_data) {
-	int ri=-1;
-	GSeqData f(gid);
-	GSeqData* r=NULL;
-	if (ref_data.Found(&f,ri))
-		r=ref_data[ri];
-	return r;
+	int l=0;
+	int h=ref_data.Count()-1;
+	while (l<=h) {
+		int i=(l+h)>>1;
+		int x=ref_data[i]->get_gseqid();
+		if (x==gid) return ref_data[i];
+		if (x<gid) l=i+1;
+		      else h=i-1;
+		}
+	return NULL;
 }
 
 void read_transcripts(FILE* f, GList<GSeqData>& seqdata, 
@@ -0,0 +1,377 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "data/cache.hpp"
+#include "tools/random.hpp"
+
+using namespace Anaquin;
+
+// Must be changed whenever the layout is changed
+#define CACHE_VERSION 3
+
+// Magic number for the entries ("ANQC")
+#define CACHE_MAGIC 0x43514e41
+
+/*
+ * Data is written in the native byte order. The cache is only meant for the same machine (or the same
+ * architecture), the version and the magic number protect from anything else.
+ */
+
+class Output
+{
+    public:
+
+        template <typename T> void pod(const T &x)
+        {
+            _x.append(reinterpret_cast<const char *>(&x), sizeof(T));
+        }
+
+        inline void str(const std::string &x)
+        {
+            pod<uint32_t>(x.size());
+            _x.append(x);
+        }
+
+        inline void locus(const Locus &l)
+        {
+            pod(l.start);
+            pod(l.end);
+        }
+
+        inline const std::string &data() const { return _x; }
+
+    private:
+        std::string _x;
+};
+
+class Input
+{
+    public:
+
+        Input(const std::string &x) : _i(x.data()), _e(x.data() + x.size()) {}
+
+        template <typename T> T pod()
+        {
+            T x;
+            need(sizeof(T));
+            memcpy(&x, _i, sizeof(T));
+            _i += sizeof(T);
+            return x;
+        }
+
+        inline void str(std::string &x)
+        {
+            const auto n = pod<uint32_t>();
+            need(n);
+            x.assign(_i, n);
+            _i += n;
+        }
+
+        inline Locus locus()
+        {
+            const auto start = pod<Base>();
+            const auto end   = pod<Base>();
+            return Locus(start, end);
+        }
+
+        inline bool done() const { return _i == _e; }
+
+    private:
+
+        inline void need(std::size_t n) const
+        {
+            if (static_cast<std::size_t>(_e - _i) < n)
+            {
+                throw std::runtime_error("Truncated cache");
+            }
+        }
+
+        const char *_i, *_e;
+};
+
+static void header(Output &o)
+{
+    o.pod<uint32_t>(CACHE_MAGIC);
+    o.pod<uint32_t>(CACHE_VERSION);
+}
+
+static void header(Input &i)
+{
+    if (i.pod<uint32_t>() != CACHE_MAGIC || i.pod<uint32_t>() != CACHE_VERSION)
+    {
+        throw std::runtime_error("Invalid cache");
+    }
+}
+
+// Keys are sorted, thus every element is inserted at the end
+template <typename M, typename F> void readMap(Input &i, M &m, F f)
+{
+    for (auto n = i.pod<uint64_t>(); n--;)
+    {
+        typename M::key_type k;
+        i.str(k);
+        m.emplace_hint(m.end(), k, f(i));
+    }
+}
+
+template <typename M, typename F> void writeMap(Output &o, const M &m, F f)
+{
+    o.pod<uint64_t>(m.size());
+
+    for (const auto &i : m)
+    {
+        o.str(i.first);
+        f(o, i.second);
+    }
+}
+
+static void writeNames(Output &o, const Names &x)
+{
+    o.pod<uint64_t>(x.size());
+
+    for (NameID i = 0; i < x.size(); i++)
+    {
+        o.str(x[i]);
+    }
+}
+
+static void readNames(Input &i, Names &x)
+{
+    for (auto n = i.pod<uint64_t>(); n--;)
+    {
+        std::string s;
+        i.str(s);
+        x.add(s);
+    }
+}
+
+// Rows are written field by field, the padding in memory is never written
+static void writeRows(Output &o, const Features &x)
+{
+    o.pod<uint64_t>(x.x.size());
+
+    for (const auto &i : x.x)
+    {
+        o.pod<uint32_t>(i.c);
+        o.pod<uint32_t>(i.g);
+        o.pod<uint32_t>(i.t);
+        o.pod<uint8_t>(i.str);
+        o.pod<Base>(i.start);
+        o.pod<Base>(i.end);
+    }
+}
+
+// The transcripts are unused for genes, thus not validated
+static Features readRows(Input &i, const GTFData &x, bool isGene)
+{
+    std::vector<Feature> r(i.pod<uint64_t>());
+
+    for (auto &j : r)
+    {
+        j.c = i.pod<uint32_t>();
+        j.g = i.pod<uint32_t>();
+        j.t = i.pod<uint32_t>();
+
+        const auto str = i.pod<uint8_t>();
+
+        j.str   = static_cast<Strand>(str);
+        j.start = i.pod<Base>();
+        j.end   = i.pod<Base>();
+
+        if (j.c >= x.cIDs.size() || j.g >= x.gIDs.size() || (!isGene && j.t >= x.tIDs.size()) || str > Strand::Either)
+        {
+            throw std::runtime_error("Invalid cache");
+        }
+    }
+
+    return Features(std::move(r), x.cIDs.size());
+}
+
+static bool readFile(const FileName &file, std::string &x)
+{
+    std::ifstream r(file, std::ios::binary);
+
+    if (!r.good())
+    {
+        return false;
+    }
+
+    r.seekg(0, std::ios::end);
+    x.resize(r.tellg());
+    r.seekg(0, std::ios::beg);
+    r.read(&x[0], x.size());
+
+    return r.good();
+}
+
+// Write to a temporary file and rename, concurrent runs never see a partial entry
+static void writeFile(const FileName &file, const std::string &x)
+{
+    const auto tmp = file + "." + std::to_string(getpid());
+
+    {
+        std::ofstream w(tmp, std::ios::binary);
+        w.write(x.data(), x.size());
+
+        if (!w.good())
+        {
+            remove(tmp.c_str());
+            return;
+        }
+    }
+
+    if (rename(tmp.c_str(), file.c_str()))
+    {
+        remove(tmp.c_str());
+    }
+}
+
+FileName Cache::dir()
+{
+    const auto x = getenv("ANAQUIN_CACHE");
+    return x ? x : "";
+}
+
+FileName Cache::path(const Reader &r, const std::string &kind)
+{
+    if (dir().empty() || r.mode() != DataMode::File)
+    {
+        return "";
+    }
+
+    std::ifstream f(r.src(), std::ios::binary);
+
+    if (!f.good())
+    {
+        return "";
+    }
+
+    Seed h = CACHE_VERSION;
+    std::vector<char> buf(1 << 20);
+
+    // Hash of the file content, block by block
+    while (f.read(buf.data(), buf.size()) || f.gcount())
+    {
+        h = hash64(buf.data(), f.gcount(), h);
+    }
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(h));
+
+    // The directory might not be there yet
+    mkdir(dir().c_str(), 0755);
+
+    return dir() + "/" + kind + "_" + key + ".bin";
+}
+
+bool Cache::load(const FileName &file, GTFData &x)
+{
+    std::string s;
+
+    if (!readFile(file, s))
+    {
+        return false;
+    }
+
+    try
+    {
+        Input i(s);
+        header(i);
+
+        readNames(i, x.cIDs);
+        readNames(i, x.gIDs);
+        readNames(i, x.tIDs);
+
+        x.gs  = readRows(i, x, true);
+        x.ts  = readRows(i, x, false);
+        x.ues = readRows(i, x, false);
+        x.uis = readRows(i, x, false);
+
+        for (NameID j = 0; j < x.cIDs.size(); j++)
+        {
+            x.c2g.push_back(i.pod<Counts>());
+        }
+
+        return i.done();
+    }
+    catch (...)
+    {
+        x = GTFData();
+        return false;
+    }
+}
+
+void Cache::save(const FileName &file, const GTFData &x)
+{
+    Output o;
+    header(o);
+
+    writeNames(o, x.cIDs);
+    writeNames(o, x.gIDs);
+    writeNames(o, x.tIDs);
+
+    writeRows(o, x.gs);
+    writeRows(o, x.ts);
+    writeRows(o, x.ues);
+    writeRows(o, x.uis);
+
+    for (const auto &i : x.c2g)
+    {
+        o.pod(i);
+    }
+
+    writeFile(file, o.data());
+}
+
+bool Cache::load(const FileName &file, Ladder &x)
+{
+    std::string s;
+
+    if (!readFile(file, s))
+    {
+        return false;
+    }
+
+    try
+    {
+        Input i(s);
+        header(i);
+
+        for (auto n = i.pod<uint64_t>(); n--;)
+        {
+            SequinID id;
+            i.str(id);
+            x.seqs.emplace_hint(x.seqs.end(), id);
+        }
+
+        readMap(i, x.m1, [&](Input &i) { return i.pod<Concent>(); });
+        readMap(i, x.m2, [&](Input &i) { return i.pod<Concent>(); });
+
+        return i.done();
+    }
+    catch (...)
+    {
+        x = Ladder();
+        return false;
+    }
+}
+
+void Cache::save(const FileName &file, const Ladder &x)
+{
+    Output o;
+    header(o);
+
+    o.pod<uint64_t>(x.seqs.size());
+
+    for (const auto &i : x.seqs)
+    {
+        o.str(i);
+    }
+
+    writeMap(o, x.m1, [&](Output &o, Concent c) { o.pod(c); });
+    writeMap(o, x.m2, [&](Output &o, Concent c) { o.pod(c); });
+
+    writeFile(file, o.data());
+}
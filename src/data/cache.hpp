@@ -0,0 +1,56 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "data/ladder.hpp"
+#include "data/reader.hpp"
+#include "tools/gtf_data.hpp"
+
+namespace Anaquin
+{
+    /*
+     * Binary cache for the processed reference files. Entries are keyed by the hash of the file content,
+     * thus a modified file never gives an out-dated entry. The cache is located by the ANAQUIN_CACHE
+     * environment variable, and disabled if it's not defined.
+     */
+
+    struct Cache
+    {
+        // Directory of the cache, empty if caching is disabled
+        static FileName dir();
+
+        // Load the data from the cache, or build it by the function and save it
+        template <typename T, typename F> static T get(const Reader &r, const std::string &kind, F f)
+        {
+            const auto file = path(r, kind);
+
+            if (file.empty())
+            {
+                return f();
+            }
+
+            T x;
+
+            if (load(file, x))
+            {
+                return x;
+            }
+
+            x = f();
+            save(file, x);
+
+            return x;
+        }
+
+        // Entry for the reader, empty if the reader can't be cached (eg: memory)
+        static FileName path(const Reader &, const std::string &kind);
+
+        // False if the entry is missing or invalid
+        static bool load(const FileName &, GTFData &);
+        static bool load(const FileName &, Ladder &);
+
+        static void save(const FileName &, const GTFData &);
+        static void save(const FileName &, const Ladder &);
+    };
+}
+
+#endif
@@ -1,21 +1,24 @@
 #ifndef COMPARE_HPP
 #define COMPARE_HPP
 
+#include <map>
+#include <string>
 #include <math.h>
 
 namespace Anaquin
 {
     /*
-     * This class represents a data-wrapper for Cuffcompare
+     * This class represents a data-wrapper for Cuffcompare. Metrics that can't be computed (eg: no
+     * intron in the reference) are left as NAN.
      */
 
     struct Compare
     {
         // Metrics at the base level
-        double b_sp, b_sn;
+        double b_sp = NAN, b_sn = NAN;
 
         // Metrics at the exon level
-        double e_sp, e_sn, e_fsp, e_fsn;
+        double e_sp = NAN, e_sn = NAN, e_fsp = NAN, e_fsn = NAN;
         
         // Metrics at the intron level
         double i_sp = NAN, i_sn = NAN, i_fsp = NAN, i_fsn = NAN;
@@ -24,16 +27,19 @@ namespace Anaquin
         double c_sp = NAN, c_sn = NAN, c_fsp = NAN, c_fsn = NAN;
 
         // Metrics at the locus level
-        double l_sp, l_sn, l_fsp, l_fsn;
+        double l_sp = NAN, l_sn = NAN, l_fsp = NAN, l_fsn = NAN;
 
         // Metrics at the transcript level
-        double t_sp, t_sn, t_fsp, t_fsn;
+        double t_sp = NAN, t_sn = NAN, t_fsp = NAN, t_fsn = NAN;
 
-        double novelExonsP, novelIntronsP;
-        double missedExonsP, missedIntronsP;
+        double novelExonsP  = NAN, novelIntronsP  = NAN;
+        double missedExonsP = NAN, missedIntronsP = NAN;
 
-        unsigned novelExonsN,  novelExonsR,    novelIntronsN, novelIntronsR;
-        unsigned missedExonsR, missedIntronsR, missedExonsN,  missedIntronsN;
+        unsigned novelExonsN  = 0, novelExonsR    = 0, novelIntronsN  = 0, novelIntronsR  = 0;
+        unsigned missedExonsR = 0, missedIntronsR = 0, missedExonsN   = 0, missedIntronsN = 0;
+
+        // Base sensitivity for each reference transcript, as if it was the only reference
+        std::map<std::string, double> t_bsn;
     };
 }
 
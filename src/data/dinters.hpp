@@ -5,7 +5,7 @@
 #include <numeric>
 #include <ss/stats.hpp>
 #include "data/data.hpp"
-#include "data/itree.hpp"
+#include "data/ilist.hpp"
 #include "data/locus.hpp"
 
 namespace Anaquin
@@ -46,18 +46,60 @@ namespace Anaquin
                 Counts zeros = 0;
             
                 inline Proportion covered() const { return static_cast<double>(nonZeros) / length; }
+            
+                /*
+                 * Quantile of the coverage for every base, the same as SS::quant() on the sorted
+                 * coverage. Computed from the histogram, nothing is sorted.
+                 */
+            
+                inline Coverage quant(double p) const
+                {
+                    Counts n = 0;
+                
+                    for (const auto &i : hist)
+                    {
+                        n += i.second;
+                    }
+                
+                    if (!n)
+                    {
+                        return NAN;
+                    }
+                
+                    const auto id = (n - 1) * p;
+                    const auto lo = static_cast<Counts>(floor(id));
+                    const auto hi = static_cast<Counts>(ceil(id));
+                    const auto h  = id - lo;
+                
+                    // Coverage for the k-th base in the sorted order
+                    auto at = [&](Counts k)
+                    {
+                        Counts c = 0;
+                    
+                        for (const auto &i : hist)
+                        {
+                            if (k < (c += i.second))
+                            {
+                                return i.first;
+                            }
+                        }
+                    
+                        return hist.rbegin()->first;
+                    };
+                
+                    return (1.0 - h) * at(lo) + h * at(hi);
+                }
             };
         
-            DInter(const IntervalID &id, const Locus &l) : _id(id), _l(l)
-            {
-                _covs.resize(l.length());
-            }
+            DInter(const IntervalID &id, const Locus &l) : _id(id), _l(l) {}
 
             inline void add(const Locus &l)
             {
-                if (l.start < _covs.size()) { _covs[l.start].starts++; }
-                if (l.end < _covs.size())   { _covs[l.end].ends++;     }
-                else                        { _covs.back().ends++;     }
+                const auto n = _l.length();
+                
+                if (l.start < n) { event(l.start, 1, 0); }
+                if (l.end < n)   { event(l.end, 0, 1);   }
+                else             { event(n - 1, 0, 1);   }
             };
 
             inline Base map(const Locus &l, Base *lp = nullptr, Base *rp = nullptr)
@@ -74,9 +116,8 @@ namespace Anaquin
             
                 if (start <= end)
                 {
-                    _covs[start].starts++;
-                    _covs[end].ends++;
-                    assert(start < _covs.size() && end < _covs.size());
+                    event(start, 1, 0);
+                    event(end, 0, 1);
                 }
             
                 // Bases to the left of the interval fails to map
@@ -96,9 +137,6 @@ namespace Anaquin
             template <typename F> Stats stats(F f) const
             {
                 Stats stats;
-                
-                // Required for estimating percentile
-                std::vector<double> x;
 
                 bedGraph([&](const ChrID &id, Base i, Base j, Coverage cov)
                 {
@@ -118,21 +156,14 @@ namespace Anaquin
                     stats.length    += n;
                     stats.hist[cov] += n;
                     
-                    for (auto i = 0; i < n; i++)
-                    {
-                        x.push_back(cov);
-                    }
-                    
                     if (!cov) { stats.zeros    += n; }
                     else      { stats.nonZeros += n; }
                 });
             
-                std::sort(x.begin(), x.end());
-                
                 stats.mean   = stats.sums / stats.length;
-                stats.p25    = SS::quant(x, 0.25);
-                stats.p50    = SS::quant(x, 0.50);
-                stats.p75    = SS::quant(x, 0.75);
+                stats.p25    = stats.quant(0.25);
+                stats.p50    = stats.quant(0.50);
+                stats.p75    = stats.quant(0.75);
                 stats.aligns = count();
 
                 return stats;
@@ -148,13 +179,25 @@ namespace Anaquin
         
             template <typename T> void bedGraph(T t) const
             {
+                compact();
+            
                 Base depth = 0;
                 long lastStart = -1;
                 long lastDepth = -1;
             
-                for (auto j = 0; j < _l.length(); j++)
+                /*
+                 * The depth only changes at an event (reads starting) or right after it (reads ending).
+                 * Bases in between have the same depth, they're skipped.
+                 */
+            
+                auto i = _events.begin();
+            
+                for (Base j = 0; j < _l.length();)
                 {
-                    depth += _covs[j].starts;
+                    // Reads starting at this base
+                    const auto here = i != _events.end() && i->pos == j;
+                
+                    depth += here ? i->starts : 0;
                 
                     if (depth != lastDepth)
                     {
@@ -168,7 +211,19 @@ namespace Anaquin
                         lastDepth = depth;
                     }
                 
-                    depth = depth - _covs[j].ends;
+                    if (here)
+                    {
+                        depth = depth - i->ends;
+                        
+                        // Reads ending here would change the depth for the next base
+                        j++;
+                        i++;
+                    }
+                    else
+                    {
+                        // Jump to the next event
+                        j = i != _events.end() ? i->pos : _l.length();
+                    }
                 }
             
                 // Print information about the last position
@@ -188,12 +243,57 @@ namespace Anaquin
 
         private:
         
-            struct Depth
+            // Reads starting and ending at a base
+            struct Event
             {
+                Base pos;
                 Base starts;
                 Base ends;
             };
         
+            inline void event(Base pos, Base starts, Base ends)
+            {
+                _events.push_back(Event { pos, starts, ends });
+            
+                // Keep the memory bounded by the number of distinct positions
+                if (_events.size() >= 2 * _compacted + 1024)
+                {
+                    compact();
+                }
+            }
+
+            // Sort the events and combine the events at the same base
+            inline void compact() const
+            {
+                if (_events.size() == _compacted)
+                {
+                    return;
+                }
+            
+                std::sort(_events.begin(), _events.end(), [&](const Event &x, const Event &y)
+                {
+                    return x.pos < y.pos;
+                });
+            
+                std::size_t n = 0;
+            
+                for (std::size_t i = 0; i < _events.size(); i++)
+                {
+                    if (n && _events[n-1].pos == _events[i].pos)
+                    {
+                        _events[n-1].starts += _events[i].starts;
+                        _events[n-1].ends   += _events[i].ends;
+                    }
+                    else
+                    {
+                        _events[n++] = _events[i];
+                    }
+                }
+            
+                _events.resize(n);
+                _compacted = n;
+            }
+        
             // The represented interval
             Locus _l;
         
@@ -202,8 +302,15 @@ namespace Anaquin
             // Number of alignments mapped to the interval
             Counts _counts = 0;
 
-            // For each base in the interval (relative to the beginning of the interval)
-            std::vector<Depth> _covs;
+            /*
+             * Events relative to the beginning of the interval. Only bases where reads start or end
+             * are stored, thus memory doesn't depend on the length of the interval.
+             */
+            
+            mutable std::vector<Event> _events;
+        
+            // Number of events sorted and combined
+            mutable std::size_t _compacted = 0;
     };
     
     template <typename T = DInter> class DIntervals
@@ -212,6 +319,36 @@ namespace Anaquin
         
             typedef std::map<typename T::IntervalID, T> IntervalData;
 
+            DIntervals() {}
+
+            // The index points to the intervals, thus it's rebuilt for a copy
+            DIntervals(const DIntervals &x) : _inters(x._inters)
+            {
+                if (x._tree)
+                {
+                    build();
+                }
+            }
+
+            DIntervals(DIntervals &&) = default;
+            DIntervals &operator=(DIntervals &&) = default;
+
+            inline DIntervals &operator=(const DIntervals &x)
+            {
+                if (this != &x)
+                {
+                    _inters = x._inters;
+                    _tree.reset();
+
+                    if (x._tree)
+                    {
+                        build();
+                    }
+                }
+
+                return *this;
+            }
+
             inline void add(const T &i)
             {
                 _inters.insert(typename std::map<typename T::IntervalID, T>::value_type(i.id(), i));
@@ -233,7 +370,7 @@ namespace Anaquin
                     throw std::runtime_error("No interval was built. loci.empty().");
                 }
             
-                _tree = std::shared_ptr<IntervalTree<T *>>(new IntervalTree<T *> { loci });
+                _tree = std::shared_ptr<IntervalList<T *>>(new IntervalList<T *>(loci));
             }
         
             inline T * find(const typename T::IntervalID &id)
@@ -246,58 +383,133 @@ namespace Anaquin
                 return _inters.count(id) ? &(_inters.at(id)) : nullptr;
             }
 
-            inline T * exact(const Locus &l, std::vector<T *> *r = nullptr) const
+            /*
+             * Visit every interval containing the locus, stop as soon as the visitor returns false.
+             * Nothing is allocated.
+             */
+
+            template <typename F> void containing(const Locus &l, F f) const
             {
-                auto v = _tree->findContains(l.start, l.end);
+                _tree->contains(l.start, l.end, [&](const Interval_<T *> &i)
+                {
+                    return f(i.value);
+                });
+            }
 
+            // Visit every interval overlapping the locus, stop as soon as the visitor returns false
+            template <typename F> void overlapping(const Locus &l, F f) const
+            {
+                _tree->overlap(l.start, l.end, [&](const Interval_<T *> &i)
+                {
+                    return f(i.value);
+                });
+            }
+
+            // The first interval exactly matching the locus, by before()
+            inline T * firstExact(const Locus &l) const
+            {
                 T *t = nullptr;
-    
-                for (const auto &i : v)
+
+                containing(l, [&](T *i)
                 {
-                    if (i.value->l() == l)
+                    if (i->l() == l && (!t || before(i, t)))
                     {
-                        t = i.value;
-                        
-                        if (r)
-                        {
-                            r->push_back(t);
-                        }
+                        t = i;
                     }
-                }
-            
+
+                    return true;
+                });
+
                 return t;
             }
-        
-            inline T * contains(const Locus &l, std::vector<T *> *r = nullptr) const
+
+            // The first interval containing the locus, by before()
+            inline T * firstContains(const Locus &l) const
+            {
+                T *t = nullptr;
+
+                containing(l, [&](T *i)
+                {
+                    t = (!t || before(i, t)) ? i : t;
+                    return true;
+                });
+
+                return t;
+            }
+
+            // The first interval overlapping the locus, by before()
+            inline T * firstOverlap(const Locus &l) const
+            {
+                T *t = nullptr;
+
+                overlapping(l, [&](T *i)
+                {
+                    t = (!t || before(i, t)) ? i : t;
+                    return true;
+                });
+
+                return t;
+            }
+
+            inline T * exact(const Locus &l, std::vector<T *> *r = nullptr) const
             {
-                auto v = _tree->findContains(l.start, l.end);
+                if (!r)
+                {
+                    return firstExact(l);
+                }
 
-                if (r)
+                T *t = nullptr;
+
+                containing(l, [&](T *i)
                 {
-                    for (const auto &i : v)
+                    if (i->l() == l)
                     {
-                        if (i.value)
-                        
-                        r->push_back(i.value);
+                        t = (!t || before(i, t)) ? i : t;
+                        r->push_back(i);
                     }
+
+                    return true;
+                });
+
+                return t;
+            }
+
+            inline T * contains(const Locus &l, std::vector<T *> *r = nullptr) const
+            {
+                if (!r)
+                {
+                    return firstContains(l);
                 }
-            
-                return v.empty() ? nullptr : v.front().value;
+
+                T *t = nullptr;
+
+                containing(l, [&](T *i)
+                {
+                    t = (!t || before(i, t)) ? i : t;
+                    r->push_back(i);
+                    return true;
+                });
+
+                return t;
             }
-        
+
             inline T * overlap(const Locus &l, std::vector<T *> *r = nullptr) const
             {
-                auto v = _tree->findOverlapping(l.start, l.end);
-            
-                if (r)
+                if (!r)
                 {
-                    for (const auto &i : v)
-                    {
-                        r->push_back(i.value);
-                    }
+                    return firstOverlap(l);
                 }
-            
-                return v.empty() ? nullptr : v.front().value;
+
+                T *t = nullptr;
+
+                overlapping(l, [&](T *i)
+                {
+                    t = (!t || before(i, t)) ? i : t;
+                    r->push_back(i);
+                    return true;
+                });
+
+                return t;
             }
 
             template <typename F> void bedGraph(F f) const
@@ -334,6 +546,9 @@ namespace Anaquin
                 }
             
                 stats.mean = stats.sums / stats.length;
+                stats.p25  = stats.quant(0.25);
+                stats.p50  = stats.quant(0.50);
+                stats.p75  = stats.quant(0.75);
             
                 return stats;
             }
@@ -354,7 +569,7 @@ namespace Anaquin
         
         private:
         
-            std::shared_ptr<IntervalTree<T *>> _tree;
+            std::shared_ptr<IntervalList<T *>> _tree;
         
             IntervalData _inters;
     };
@@ -0,0 +1,178 @@
+#ifndef ILIST_HPP
+#define ILIST_HPP
+
+#include <vector>
+#include <algorithm>
+#include "data/itree.hpp"
+
+namespace Anaquin
+{
+    /*
+     * Array-backed interval index (augmented interval list). Intervals are sorted by the start positions
+     * and each keeps the running maximum end of the intervals before it. A query finds the last interval
+     * starting before the end of the query by binary search, and scans backward until the running maximum
+     * falls behind the query.
+     *
+     * Intervals covering many others would make the scan long, thus they're moved to a separate list.
+     * That's repeated for a few times, the last list keeps whatever left.
+     *
+     * Intervals are closed, the same as IntervalTree. Queries don't allocate.
+     */
+
+    template <typename T, typename K = std::size_t> class IntervalList
+    {
+        public:
+
+            typedef Interval_<T, K> Interval;
+
+            IntervalList() {}
+
+            IntervalList(const std::vector<Interval> &x)
+            {
+                auto y = x;
+
+                std::sort(y.begin(), y.end(), [&](const Interval &i, const Interval &j)
+                {
+                    return i.start < j.start || (i.start == j.start && i.stop < j.stop);
+                });
+
+                while (!y.empty())
+                {
+                    std::vector<Interval> rest;
+
+                    if (_o.size() < MaxLists - 1 && y.size() > Window)
+                    {
+                        std::vector<Interval> keep;
+
+                        for (std::size_t i = 0; i < y.size(); i++)
+                        {
+                            // Number of the following intervals covered by this interval
+                            std::size_t n = 0;
+
+                            for (auto j = i + 1; j < y.size() && j <= i + Window; j++)
+                            {
+                                if (y[j].stop <= y[i].stop)
+                                {
+                                    n++;
+                                }
+                            }
+
+                            (n >= Window / 2 ? rest : keep).push_back(y[i]);
+                        }
+
+                        // Not worth another list
+                        if (rest.size() < Window)
+                        {
+                            rest.clear();
+                        }
+                        else
+                        {
+                            y = keep;
+                        }
+                    }
+
+                    _o.push_back(_x.size());
+
+                    for (std::size_t i = 0; i < y.size(); i++)
+                    {
+                        const auto max = i ? std::max(_b.back().max, y[i].stop) : y[i].stop;
+
+                        _x.push_back(y[i]);
+                        _b.push_back(Bound { y[i].start, y[i].stop, max });
+                    }
+
+                    y = rest;
+                }
+
+                _o.push_back(_x.size());
+            }
+
+            /*
+             * Visit every interval overlapping [start, stop]. Each list is visited in the reversed order of
+             * the start positions. The query stops as soon as the visitor returns false.
+             */
+
+            template <typename F> void overlap(K start, K stop, F f) const
+            {
+                for (std::size_t i = 0; i + 1 < _o.size(); i++)
+                {
+                    const auto b = _b.begin() + _o[i];
+                    const auto e = _b.begin() + _o[i + 1];
+
+                    // Number of intervals in the list starting before the end of the query
+                    auto n = std::upper_bound(b, e, stop, [&](K x, const Bound &j) { return x < j.start; }) - b;
+
+                    for (auto j = _o[i] + n; j-- > _o[i] && _b[j].max >= start;)
+                    {
+                        if (_b[j].stop >= start && !f(_x[j]))
+                        {
+                            return;
+                        }
+                    }
+                }
+            }
+
+            // Visit every interval containing [start, stop], stop as soon as the visitor returns false
+            template <typename F> void contains(K start, K stop, F f) const
+            {
+                overlap(start, stop, [&](const Interval &i)
+                {
+                    return !(i.start <= start && stop <= i.stop) || f(i);
+                });
+            }
+
+            // Visit every interval contained in [start, stop], stop as soon as the visitor returns false
+            template <typename F> void contained(K start, K stop, F f) const
+            {
+                overlap(start, stop, [&](const Interval &i)
+                {
+                    return !(start <= i.start && i.stop <= stop) || f(i);
+                });
+            }
+
+            inline std::size_t size() const { return _x.size(); }
+
+        private:
+
+            enum
+            {
+                // Number of the following intervals checked for coverage
+                Window = 20,
+
+                // Maximum number of lists
+                MaxLists = 10,
+            };
+
+            struct Bound
+            {
+                K start, stop;
+
+                // Maximum end of the intervals up to here in the list
+                K max;
+            };
+
+            // Intervals of all lists
+            std::vector<Interval> _x;
+
+            // Coordinates packed together, the scan doesn't touch the values
+            std::vector<Bound> _b;
+
+            // Offsets of the lists, plus the total
+            std::vector<std::size_t> _o;
+    };
+
+    /*
+     * Order of the matches for the first*() queries on MergedIntervals and DIntervals, the lowest start
+     * and then the lowest end. The name breaks the tie of identical loci. SweepIntervals takes the same
+     * order.
+     */
+
+    template <typename T> inline bool before(const T *x, const T *y)
+    {
+        return x->l().start < y->l().start ||
+              (x->l().start == y->l().start && (x->l().end < y->l().end ||
+              (x->l().end == y->l().end && x->id() < y->id())));
+    }
+}
+
+#endif
@@ -2,169 +2,145 @@
 
 using namespace Anaquin;
 
+// Number of pending alignments before they're merged
+#define BATCH_SIZE 4096
+
 std::set<Locus> MergedInterval::zeros() const
 {
     std::set<Locus> r;
-    
+
     Base i = 1;
-    
-    for (auto &j : _data)
+
+    for (const auto &j : runs())
     {
-        if (i < j.second.start)
+        if (i < j.start)
         {
-            r.insert(Locus(i, j.second.start-1));
+            r.insert(Locus(i, j.start-1));
         }
-        
-        i = j.second.end + 1;
+
+        i = j.end + 1;
     }
 
     return r;
 }
 
-Base MergedInterval::map(const Locus &l, Base *lp, Base *rp)
+void MergedInterval::flush() const
 {
-    bool added = true;
-    bool p1 = true;
-    bool p2 = false;
-    
-    // Pointing to the matching
-    Locus *m = nullptr;
-    
-    Base left  = 0;
-    Base right = 0;
-    
-    Base origKey = 0;
-    
-    auto fixKey = [&]()
+    if (_pending.empty())
     {
-        assert(_data.count(origKey));
-        assert(m && origKey && m->start && m->end);
-        
-        auto iter = _data.find(origKey);
-        assert(iter != _data.end());
-        
-        // Remove the old key
-        _data.erase(iter);
-        
-        auto l = *m;
-        
-        // Add the new key
-        _data[l.end] = l;
-    };
-    
-    if (!std::isnan(_x) && l.start < _x && l.end < _x)
-    {
-        added = true;
+        return;
     }
-    else if (!std::isnan(_y) && l.start > _y && l.end > _y)
+
+    std::sort(_pending.begin(), _pending.end(), [&](const Locus &x, const Locus &y)
     {
-        added = true;
+        return x.start < y.start;
+    });
+
+    std::vector<Locus> r;
+    r.reserve(_data.size() + _pending.size());
+
+    auto i = _data.begin();
+    auto j = _pending.begin();
+
+    // Merge both sorted lists, only overlapping runs are combined
+    while (i != _data.end() || j != _pending.end())
+    {
+        const auto &x = (j == _pending.end() || (i != _data.end() && i->start <= j->start)) ? *i++ : *j++;
+
+        if (!r.empty() && x.start <= r.back().end)
+        {
+            r.back().end = std::max(r.back().end, x.end);
+        }
+        else
+        {
+            r.push_back(x);
+        }
     }
-    else
+
+    _data.swap(r);
+    _pending.clear();
+}
+
+void MergedInterval::add(const Locus &l)
+{
+    const auto x = Locus(std::max(l.start, _l.start), std::min(l.end, _l.end));
+
+    if (x.start > x.end)
     {
-        // Can we quickly find a match by log(n)?
-        auto iter = _data.lower_bound(l.start);
-        
-        auto it = iter;
+        return;
+    }
 
-        if (!it->second.overlap(l))
+    // Sorted alignments only touch the last run
+    if (_pending.empty() && (_data.empty() || x.start >= _data.back().start))
+    {
+        if (!_data.empty() && x.start <= _data.back().end)
         {
-            added = true;
+            _data.back().end = std::max(_data.back().end, x.end);
         }
         else
         {
-            assert(it != _data.end());
-            assert(it->second.overlap(l));
-            
-            for (; it != _data.cend();)
-            {
-                auto &j = it->second;
-                
-                if (!j.overlap(l))
-                {
-                    break;
-                }
-                
-                if (p1)
-                {
-                    if (j.overlap(l))
-                    {
-                        origKey = it->first;
-                        added = false;
-                        
-                        left  = ((l.start < j.start) ? j.start -  l.start : 0);
-                        right = ((l.end   > j.end)   ?  l.end  - j.end   : 0);
-                        
-                        j.start = std::min(j.start, l.start);
-                        j.end   = std::max(j.end,   l.end);
-                        j.start = std::max(j.start, _l.start);
-                        j.end   = std::min(j.end,   _l.end);
-
-                        // So that we can access it in the later iterations
-                        m = &j;
-                        
-                        if (lp) { *lp = left;  }
-                        if (rp) { *rp = right; }
-                        
-                        p1 = false;
-                        p2 = true;
-                    }
-                }
-                else if (p2)
-                {
-                    if (!j.overlap(l))
-                    {
-                        _x = _data.begin()->second.start;
-                        _y = _data.end()->second.end;
-                        
-                        fixKey();
-
-                        return (left + right);
-                    }
-                    
-                    m->start = std::min(m->start, j.start);
-                    m->end   = std::max(m->end,   j.end);
-                    m->start = std::max(m->start, _l.start);
-                    m->end   = std::min(m->end,   _l.end);
-                    
-                    // Remove the overlapping entry
-                    _data.erase(it++);
-                    
-                    continue;
-                }
-                else
-                {
-                    throw std::runtime_error("Invalid phase");
-                }
-                
-                ++it;
-            }
+            _data.push_back(x);
+        }
+    }
+    else
+    {
+        _pending.push_back(x);
+
+        if (_pending.size() >= BATCH_SIZE)
+        {
+            flush();
         }
     }
-    
-    if (added)
+}
+
+Base MergedInterval::map(const Locus &l, Base *lp, Base *rp)
+{
+    const auto x = Locus(std::max(l.start, _l.start), std::min(l.end, _l.end));
+
+    if (x.start > x.end)
+    {
+        return 0;
+    }
+
+    flush();
+
+    Base left  = 0;
+    Base right = 0;
+
+    // The first run that could overlap (the runs are sorted by both ends)
+    auto i = std::lower_bound(_data.begin(), _data.end(), l.start, [&](const Locus &j, Base s)
     {
-        auto start = l.start;
-        auto end = l.end;
-        
-        start = std::max(start, _l.start);
-        end   = std::min(end,   _l.end);
-        
-        _data[end] = Locus(start, end);
-        
+        return j.end < s;
+    });
+
+    if (i == _data.end() || i->start > l.end)
+    {
+        _data.insert(i, x);
+
         left  = ((l.start < _l.start) ? _l.start -  l.start : 0);
         right = ((l.end   > _l.end)   ?  l.end  - _l.end   : 0);
     }
     else
     {
-        fixKey();
+        left  = ((l.start < i->start) ? i->start -  l.start : 0);
+        right = ((l.end   > i->end)   ?  l.end  - i->end   : 0);
+
+        i->start = std::min(i->start, x.start);
+        i->end   = std::max(i->end,   x.end);
+
+        // Remove the following runs now overlapping
+        auto j = i + 1;
+
+        for (; j != _data.end() && j->start <= i->end; j++)
+        {
+            i->end = std::max(i->end, j->end);
+        }
+
+        _data.erase(i + 1, j);
     }
-    
+
     if (lp) { *lp = left;  }
     if (rp) { *rp = right; }
-    
-    _x = _data.begin()->second.start;
-    _y = _data.rbegin()->second.end;
-    
+
     return left + right;
 }
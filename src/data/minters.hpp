@@ -6,12 +6,17 @@
 #include <cmath>
 #include <numeric>
 #include "data/data.hpp"
-#include "data/itree.hpp"
+#include "data/ilist.hpp"
 #include "data/locus.hpp"
 #include "tools/errors.hpp"
 
 namespace Anaquin
 {
+    /*
+     * Coverage is merged lazily, even by the const accessors (runs(), stats(), size() and zeros()).
+     * Not thread-safe, each thread should map to its own copy.
+     */
+
     class MergedInterval : public Matched
     {
         public:
@@ -37,15 +42,23 @@ namespace Anaquin
             // Return loci where no alignment
             std::set<Locus> zeros() const;
         
+            /*
+             * Map an alignment, merged with the existing coverage. Return the number of bases
+             * outside the first overlapping coverage, lp and rp give them for each side.
+             */
+
             Base map(const Locus &l, Base *lp = nullptr, Base *rp = nullptr);
+
+            // Same as map() without the bases outside, the alignment might be merged later in a batch
+            void add(const Locus &l);
         
             template <typename F> Stats stats(F f) const
             {
                 Stats stats;
 
-                for (const auto &i : _data)
+                for (const auto &i : runs())
                 {
-                    stats.nonZeros += i.second.length();
+                    stats.nonZeros += i.length();
                 }
                 
                 stats.length = _l.length();
@@ -72,19 +85,27 @@ namespace Anaquin
         
             inline IntervalID name() const override { return id(); }
         
-            inline std::size_t size() { return _data.size(); }
+            // Merged coverage, sorted and non-overlapping
+            inline const std::vector<Locus> &runs() const
+            {
+                flush();
+                return _data;
+            }
         
-        //private:
+            inline std::size_t size() const { return runs().size(); }
         
-            // The first base of the mini-region
-            Base _x = NAN;
+        private:
         
-            // The last base of the mini-region
-            Base _y = NAN;
+            // Merge the pending alignments into the coverage
+            void flush() const;
         
             Locus _l;
 
-            std::map<Base, Locus> _data;
+            // Sorted and non-overlapping runs of coverage
+            mutable std::vector<Locus> _data;
+        
+            // Alignments not merged yet (not sorted)
+            mutable std::vector<Locus> _pending;
         
             GeneID  _gID;
             TransID _tID;
@@ -107,6 +128,36 @@ namespace Anaquin
         
             typedef std::map<typename T::IntervalID, T> IntervalData;
 
+            MergedIntervals() {}
+
+            // The index points to the intervals, thus it's rebuilt for a copy
+            MergedIntervals(const MergedIntervals &x) : _inters(x._inters)
+            {
+                if (x._tree)
+                {
+                    build();
+                }
+            }
+
+            MergedIntervals(MergedIntervals &&) = default;
+            MergedIntervals &operator=(MergedIntervals &&) = default;
+
+            inline MergedIntervals &operator=(const MergedIntervals &x)
+            {
+                if (this != &x)
+                {
+                    _inters = x._inters;
+                    _tree.reset();
+
+                    if (x._tree)
+                    {
+                        build();
+                    }
+                }
+
+                return *this;
+            }
+
             inline void add(const T &i)
             {
                 _inters.insert(typename std::map<typename T::IntervalID, T>::value_type(i.id(), i));
@@ -144,7 +195,7 @@ namespace Anaquin
                 
                 A_CHECK(!loci.empty(), "No interval was built. Zero interval.");
             
-                _tree = std::shared_ptr<IntervalTree<T *>>(new IntervalTree<T *> { loci });
+                _tree = std::shared_ptr<IntervalList<T *>>(new IntervalList<T *>(loci));
 
                 A_CHECK(_tree, "Failed to build interval treee");
             }
@@ -159,76 +210,145 @@ namespace Anaquin
                 return _inters.count(id) ? &(_inters.at(id)) : nullptr;
             }
 
-            inline T * exact(const Locus &l, std::vector<T *> *r = nullptr) const
+            /*
+             * Visit every interval containing the locus, stop as soon as the visitor returns false.
+             * Nothing is allocated.
+             */
+
+            template <typename F> void containing(const Locus &l, F f) const
             {
                 // This could happen for chrM (no intron)
                 if (!_tree)
                 {
-                    return nullptr;
+                    return;
                 }
-                
-                auto v = _tree->findContains(l.start, l.end);
 
+                _tree->contains(l.start, l.end, [&](const Interval_<T *> &i)
+                {
+                    return f(i.value);
+                });
+            }
+
+            // Visit every interval overlapping the locus, stop as soon as the visitor returns false
+            template <typename F> void overlapping(const Locus &l, F f) const
+            {
+                // This could happen for chrM (no intron)
+                if (!_tree)
+                {
+                    return;
+                }
+
+                _tree->overlap(l.start, l.end, [&](const Interval_<T *> &i)
+                {
+                    return f(i.value);
+                });
+            }
+
+            // The first interval exactly matching the locus, by before()
+            inline T * firstExact(const Locus &l) const
+            {
                 T *t = nullptr;
-    
-                for (const auto &i : v)
+
+                containing(l, [&](T *i)
                 {
-                    if (i.value->l() == l)
+                    if (i->l() == l && (!t || before(i, t)))
                     {
-                        t = i.value;
-                        
-                        if (r)
-                        {
-                            r->push_back(t);
-                        }
+                        t = i;
                     }
-                }
-            
+
+                    return true;
+                });
+
                 return t;
             }
-        
-            inline T * contains(const Locus &l, std::vector<T *> *r = nullptr) const
+
+            // The first interval containing the locus, by before()
+            inline T * firstContains(const Locus &l) const
             {
-                // This could happen for chrM (no intron)
-                if (!_tree)
+                T *t = nullptr;
+
+                containing(l, [&](T *i)
                 {
-                    return nullptr;
+                    t = (!t || before(i, t)) ? i : t;
+                    return true;
+                });
+
+                return t;
+            }
+
+            // The first interval overlapping the locus, by before()
+            inline T * firstOverlap(const Locus &l) const
+            {
+                T *t = nullptr;
+
+                overlapping(l, [&](T *i)
+                {
+                    t = (!t || before(i, t)) ? i : t;
+                    return true;
+                });
+
+                return t;
+            }
+
+            inline T * exact(const Locus &l, std::vector<T *> *r = nullptr) const
+            {
+                if (!r)
+                {
+                    return firstExact(l);
                 }
 
-                auto v = _tree->findContains(l.start, l.end);
+                T *t = nullptr;
 
-                if (r)
+                containing(l, [&](T *i)
                 {
-                    for (const auto &i : v)
+                    if (i->l() == l)
                     {
-                        if (i.value)
-                        
-                        r->push_back(i.value);
+                        t = (!t || before(i, t)) ? i : t;
+                        r->push_back(i);
                     }
+
+                    return true;
+                });
+
+                return t;
+            }
+
+            inline T * contains(const Locus &l, std::vector<T *> *r = nullptr) const
+            {
+                if (!r)
+                {
+                    return firstContains(l);
                 }
-            
-                return v.empty() ? nullptr : v.front().value;
+
+                T *t = nullptr;
+
+                containing(l, [&](T *i)
+                {
+                    t = (!t || before(i, t)) ? i : t;
+                    r->push_back(i);
+                    return true;
+                });
+
+                return t;
             }
-        
+
             inline T * overlap(const Locus &l, std::vector<T *> *r = nullptr) const
             {
-                // This could happen for chrM (no intron)
-                if (!_tree)
+                if (!r)
                 {
-                    return nullptr;
+                    return firstOverlap(l);
                 }
 
-                auto v = _tree->findOverlapping(l.start, l.end);
-            
-                if (r)
+                T *t = nullptr;
+
+                overlapping(l, [&](T *i)
                 {
-                    for (const auto &i : v)
-                    {
-                        r->push_back(i.value);
-                    }
-                }
-            
-                return v.empty() ? nullptr : v.front().value;
+                    t = (!t || before(i, t)) ? i : t;
+                    r->push_back(i);
+                    return true;
+                });
+
+                return t;
             }
 
             typename MergedIntervals::Stats stats() const
@@ -271,7 +391,7 @@ namespace Anaquin
         
         //private:
         
-            std::shared_ptr<IntervalTree<T *>> _tree;
+            std::shared_ptr<IntervalList<T *>> _tree;
         
             IntervalData _inters;
     };
@@ -0,0 +1,75 @@
+#ifndef NAMES_HPP
+#define NAMES_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+namespace Anaquin
+{
+    // Index to a string table
+    typedef uint32_t NameID;
+
+    /*
+     * Interned strings. Each name is kept once and referred by the index, given by the order it's
+     * first seen.
+     */
+
+    class Names
+    {
+        public:
+
+            inline NameID add(const std::string &x)
+            {
+                const auto i = _i.insert(std::make_pair(x, static_cast<NameID>(_s.size())));
+
+                if (i.second)
+                {
+                    _s.push_back(x);
+                }
+
+                return i.first->second;
+            }
+
+            // Throws std::out_of_range if the name is unknown, the same as std::map::at()
+            inline NameID at(const std::string &x) const { return _i.at(x); }
+
+            inline bool count(const std::string &x) const { return _i.count(x); }
+
+            inline const std::string &operator[](NameID i) const { return _s[i]; }
+
+            inline std::size_t size() const { return _s.size(); }
+
+            // Position of each name if the names were sorted
+            inline std::vector<NameID> ranks() const
+            {
+                std::vector<NameID> x(_s.size()), r(_s.size());
+
+                for (NameID i = 0; i < x.size(); i++)
+                {
+                    x[i] = i;
+                }
+
+                std::sort(x.begin(), x.end(), [&](NameID i, NameID j)
+                {
+                    return _s[i] < _s[j];
+                });
+
+                for (NameID i = 0; i < x.size(); i++)
+                {
+                    r[x[i]] = i;
+                }
+
+                return r;
+            }
+
+        private:
+
+            std::vector<std::string> _s;
+            std::unordered_map<std::string, NameID> _i;
+    };
+}
+
+#endif
@@ -1,32 +1,110 @@
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <zlib.h>
+#include <cstring>
 #include <assert.h>
 #include "data/reader.hpp"
 #include <boost/algorithm/string.hpp>
 
 using namespace Anaquin;
 
+// Size of a block read from the file
+#define BLOCK_SIZE (1 << 20)
+
 struct Anaquin::ReaderInternal
 {
+    ~ReaderInternal()
+    {
+        if (f)
+        {
+            gzclose(f);
+        }
+    }
+    
+    void open()
+    {
+        /*
+         * zlib reads plain files as they are, gzip and bgzip (concatenated gzip members) files are
+         * decompressed on the fly.
+         */
+        
+        if (!(f = gzopen(file.c_str(), "rb")))
+        {
+            throw InvalidFileError(file);
+        }
+        
+        gzbuffer(f, BLOCK_SIZE);
+        
+        buf.resize(BLOCK_SIZE);
+        fill();
+        
+        if (i == n)
+        {
+            throw InvalidFileError(file);
+        }
+    }
+
+    // Read the next block, the unread data is kept at the front of the buffer
+    void fill()
+    {
+        if (eof)
+        {
+            return;
+        }
+        
+        memmove(buf.data(), buf.data() + i, n - i);
+        
+        n -= i;
+        i  = 0;
+        
+        // The line is longer than the buffer
+        if (n == buf.size())
+        {
+            buf.resize(2 * buf.size());
+        }
+        
+        const auto r = gzread(f, buf.data() + n, buf.size() - n);
+        
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to read: " + file);
+        }
+
+        n += r;
+        eof = r == 0;
+    }
+
     Line line;
     
     // Defined only for file input
     std::string file;
     
-    // Implementation for file
-    std::shared_ptr<std::ifstream> f;
+    // Implementation for file (can be compressed)
+    gzFile f = nullptr;
+
+    // Lines are read from the buffer, the whole data for memory
+    std::vector<char> buf;
 
-    // Implementation for memory
-    std::shared_ptr<std::stringstream> s;
+    // Position of the next line and the end of the data in the buffer
+    std::size_t i = 0, n = 0;
+
+    bool eof = false;
 };
 
 Reader::Reader(const Reader &r)
 {
     _imp = new ReaderInternal();
     _imp->line = r._imp->line;
-    _imp->f = r._imp->f;
-    _imp->s = r._imp->s;
+    _imp->file = r._imp->file;
+
+    if (r._imp->f)
+    {
+        _imp->open();
+    }
+    else
+    {
+        _imp->buf = r._imp->buf;
+        _imp->n   = r._imp->n;
+        _imp->eof = true;
+    }
 
     // Make sure we start off from the default state
     reset();
@@ -40,31 +118,18 @@ Reader::Reader(const std::string &file, DataMode mode)
     }
     
     _imp = new ReaderInternal();
-    _imp->file = file;
 
     if (mode == DataMode::File)
     {
-        const auto f = std::shared_ptr<std::ifstream>(new std::ifstream(file));
-
-        if (!f->good())
-        {
-            throw InvalidFileError(file);
-        }
-        else if (f->peek() == std::ifstream::traits_type::eof())
-        {
-            throw InvalidFileError(file);
-        }
-
-        _imp->f = f;
+        _imp->file = file;
+        _imp->open();
     }
     else
     {
-        if (file.empty())
-        {
-            throw InvalidFileError(file);
-        }
-
-        _imp->s = std::shared_ptr<std::stringstream>(new std::stringstream(file));
+        _imp->file = file;
+        _imp->buf.assign(file.begin(), file.end());
+        _imp->n   = file.size();
+        _imp->eof = true;
     }
 }
 
@@ -82,14 +147,16 @@ void Reader::reset()
 {
     if (_imp->f)
     {
-        _imp->f->clear();
-        _imp->f->seekg(0, std::ios::beg);
+        gzrewind(_imp->f);
+        
+        _imp->i   = 0;
+        _imp->n   = 0;
+        _imp->eof = false;
+        _imp->fill();
     }
-    
-    if (_imp->s)
+    else
     {
-        _imp->s->clear();
-        _imp->s->seekg(0, std::ios::beg);
+        _imp->i = 0;
     }
 }
 
@@ -98,24 +165,61 @@ std::string Reader::src() const
     return _imp->file;
 }
 
-bool Reader::nextLine(std::string &line) const
+DataMode Reader::mode() const
 {
-    retry:
+    return _imp->f ? DataMode::File : DataMode::String;
+}
 
-    if ((_imp->f && std::getline(*_imp->f, line)) || (_imp->s && std::getline(*_imp->s, line)))
+bool Reader::nextLine(LineView &x) const
+{
+    auto &m = *_imp;
+    
+    for (;;)
     {
-        if (line.empty())
+        auto p = static_cast<char *>(memchr(m.buf.data() + m.i, '\n', m.n - m.i));
+
+        if (!p && !m.eof)
+        {
+            m.fill();
+            continue;
+        }
+        else if (!p && m.i == m.n)
         {
-            goto retry;
+            return false;
         }
+        
+        // The last line might not have a new line
+        const auto e = p ? p : m.buf.data() + m.n;
+
+        x.s = m.buf.data() + m.i;
+        x.n = e - x.s;
+
+        m.i = (e - m.buf.data()) + (p ? 1 : 0);
 
-        boost::trim(line);
+        if (!x.n)
+        {
+            continue;
+        }
+
+        // The same as boost::trim()
+        for (; x.n && isspace(x.s[0]); x.s++, x.n--);
+        for (; x.n && isspace(x.s[x.n - 1]); x.n--);
+        
         return true;
     }
-    else
+}
+
+bool Reader::nextLine(std::string &line) const
+{
+    LineView x;
+    
+    if (nextLine(x))
     {
-        return false;
+        line.assign(x.s, x.n);
+        return true;
     }
+    
+    return false;
 }
 
 bool Reader::nextTokens(std::vector<std::string> &toks, const std::string &c) const
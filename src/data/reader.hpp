@@ -16,9 +16,20 @@ namespace Anaquin
         String,
     };
     
+    // Line in the buffer of the reader, valid until the next line is read
+    struct LineView
+    {
+        const char *s = nullptr;
+
+        // Number of characters
+        std::size_t n = 0;
+
+        inline std::string str() const { return std::string(s, n); }
+    };
+
     /*
      * Reader encapsulates the underlying data source. For example, we could source from a memory string
-     * or a physical file.
+     * or a physical file. Files are read by large blocks, gzip and bgzip files are decompressed on the fly.
      */
 
     class Reader
@@ -33,10 +44,15 @@ namespace Anaquin
         
             // Returns description for the source
             std::string src() const;
+
+            DataMode mode() const;
         
             // Returns the next line in the file
             bool nextLine(std::string &) const;
 
+            // Returns the next line without copying
+            bool nextLine(LineView &) const;
+
             // Returns the next line and parse it into tokens
             bool nextTokens(std::vector<std::string> &, const std::string &c) const;
 
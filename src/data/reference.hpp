@@ -4,6 +4,7 @@
 #include "data/bData.hpp"
 #include "data/reader.hpp"
 #include "data/variant.hpp"
+#include "data/names.hpp"
 #include "data/minters.hpp"
 #include "data/dinters.hpp"
 #include "tools/gtf_data.hpp"
@@ -144,8 +145,12 @@ namespace Anaquin
             typedef std::set<SequinID> SequinIDs;
 
             inline SequinIDs seqs()   const { return _seqs; }
-            inline SequinIDs seqsL1() const { return _l1->seqs; }
-            inline SequinIDs seqsL2() const { return _l2->seqs; }
+            inline const SequinIDs &seqsL1() const { return _l1->seqs; }
+            inline const SequinIDs &seqsL2() const { return _l2->seqs; }
+
+            // Hashed sequins in the first two ladders, for membership of every record
+            inline const Names &namesL1() const { return _n1; }
+            inline const Names &namesL2() const { return _n2; }
 
             inline Name t1(const Name &x) const { return _t1->translate(x); }
             inline Name t2(const Name &x) const { return _t2->translate(x); }
@@ -193,6 +198,11 @@ namespace Anaquin
             inline void finalize(Tool x, const UserReference &r)
             {
                 validate(x, r);
+                
+                _n1 = _n2 = Names();
+                
+                if (_l1) { for (const auto &i : _l1->seqs) { _n1.add(i); } }
+                if (_l2) { for (const auto &i : _l2->seqs) { _n2.add(i); } }
             }
 
         protected:
@@ -372,6 +382,9 @@ namespace Anaquin
             // Sequin ladders
             std::shared_ptr<Ladder> _l1, _l2, _l3, _l4, _l5, _l6;
 
+            // Sequins in the first two ladders (built by finalize())
+            Names _n1, _n2;
+
             // Translation
             std::shared_ptr<Translate> _t1, _t2;
     };
@@ -450,9 +463,6 @@ namespace Anaquin
      * -------------------- Transcriptome Reference --------------------
      */
     
-    struct GeneData;
-    struct TransData;
-    
     class RnaRef : public Reference
     {
         public:
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <assert.h>
 #include <algorithm>
+#include "data/cache.hpp"
 #include "data/reader.hpp"
 #include "data/tokens.hpp"
 #include "tools/errors.hpp"
@@ -55,7 +56,10 @@ BedData Standard::readBED(const Reader &r, Base trim, const std::set<SequinID> *
 
 std::shared_ptr<GTFData> Standard::readGTF(const Reader &r)
 {
-    return std::shared_ptr<GTFData>(new GTFData(gtfData(r)));
+    return std::shared_ptr<GTFData>(new GTFData(Cache::get<GTFData>(r, "gtf", [&]()
+    {
+        return gtfData(r);
+    })));
 }
 
 template <typename Reference> Translate readTranslate(const Reader &r, Reference &ref, TranslateFormat format, Translate x = Translate())
@@ -126,26 +130,38 @@ template <typename Reference> Ladder readLadder(const Reader &r, Reference &ref,
 
 Ladder Standard::readLength(const Reader &r)
 {
-    A_CHECK(countColumns(r) >= 2, "Invalid mixture file. Expected two or more columns.");
-    return readLadder(Reader(r), r_rna, Mix_1, X_M);
+    return Cache::get<Ladder>(r, "length", [&]()
+    {
+        A_CHECK(countColumns(r) >= 2, "Invalid mixture file. Expected two or more columns.");
+        return readLadder(Reader(r), r_rna, Mix_1, X_M);
+    });
 }
 
 Ladder Standard::addCNV(const Reader &r)
 {
-    A_CHECK(countColumns(r) == 2, "Invalid mixture file for CNV ladder.");
-    return readLadder(Reader(r), r_var, Mix_1, X_M);
+    return Cache::get<Ladder>(r, "cnv", [&]()
+    {
+        A_CHECK(countColumns(r) == 2, "Invalid mixture file for CNV ladder.");
+        return readLadder(Reader(r), r_var, Mix_1, X_M);
+    });
 }
 
 Ladder Standard::addCon1(const Reader &r)
 {
-    A_CHECK(countColumns(r) == 4, "Invalid mixture file for conjoint ladder.");
-    return readLadder(Reader(r), r_var, Mix_1, M_X_M);
+    return Cache::get<Ladder>(r, "con1", [&]()
+    {
+        A_CHECK(countColumns(r) == 4, "Invalid mixture file for conjoint ladder.");
+        return readLadder(Reader(r), r_var, Mix_1, M_X_M);
+    });
 }
 
 Ladder Standard::addCon2(const Reader &r)
 {
-    A_CHECK(countColumns(r) == 4, "Invalid mixture file for conjoint ladder.");
-    return readLadder(Reader(r), r_var, Mix_1, X_M_X_M);
+    return Cache::get<Ladder>(r, "con2", [&]()
+    {
+        A_CHECK(countColumns(r) == 4, "Invalid mixture file for conjoint ladder.");
+        return readLadder(Reader(r), r_var, Mix_1, X_M_X_M);
+    });
 }
 
 Translate Standard::addSeq2Unit(const Reader &r)
@@ -162,22 +178,31 @@ Translate Standard::addUnit2Seq(const Reader &r)
 
 Ladder Standard::addAF(const Reader &r)
 {
-    A_CHECK(countColumns(r) == 2, "Invalid mixture file for allele frequnecy ladder.");
-    return readLadder(Reader(r), r_var, Mix_1, X_M);
+    return Cache::get<Ladder>(r, "af", [&]()
+    {
+        A_CHECK(countColumns(r) == 2, "Invalid mixture file for allele frequnecy ladder.");
+        return readLadder(Reader(r), r_var, Mix_1, X_M);
+    });
 }
 
 Ladder Standard::addMMix(const Reader &r)
 {
-    A_CHECK(countColumns(r) == 4, "Invalid mixture file. Expected three or more columns.");
-    auto l = readLadder(Reader(r), r_meta, Mix_1, X_M);
-    return readLadder(Reader(r), r_meta, Mix_2, M_X_M, l);
+    return Cache::get<Ladder>(r, "mmix", [&]()
+    {
+        A_CHECK(countColumns(r) == 4, "Invalid mixture file. Expected three or more columns.");
+        auto l = readLadder(Reader(r), r_meta, Mix_1, X_M);
+        return readLadder(Reader(r), r_meta, Mix_2, M_X_M, l);
+    });
 }
 
 Ladder Standard::readIsoform(const Reader &r)
 {
-    A_CHECK(countColumns(r) == 4, "Invalid mixture file. Expected three columns.");
-    auto l = readLadder(Reader(r), r_rna, Mix_1, M_X_M);
-    return readLadder(Reader(r), r_rna, Mix_2, X_X_X_M, l);
+    return Cache::get<Ladder>(r, "isoform", [&]()
+    {
+        A_CHECK(countColumns(r) == 4, "Invalid mixture file. Expected three columns.");
+        auto l = readLadder(Reader(r), r_rna, Mix_1, M_X_M);
+        return readLadder(Reader(r), r_rna, Mix_2, X_X_X_M, l);
+    });
 }
 
 Ladder Standard::readIDiff(const Reader &r)
@@ -0,0 +1,147 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <vector>
+#include <algorithm>
+#include "data/ilist.hpp"
+#include "data/locus.hpp"
+
+namespace Anaquin
+{
+    /*
+     * Sweep-line over reference intervals for coordinate-sorted alignments. The intervals are sorted
+     * by the start positions, each keeps the running maximum end of the intervals before it. The
+     * cursor is moved forward with the alignments. Intervals behind the cursor end before the current
+     * alignment, so they can't match anything for the rest of the chromosome.
+     *
+     * Moving the cursor backward is allowed (eg: unsorted alignments), but it costs a binary search.
+     * The first match is taken, the lowest start and then the lowest end (the name breaks the tie of
+     * identical loci), the same as before() for the first*() queries. The scans stop at the match.
+     */
+
+    template <typename T> class SweepIntervals
+    {
+        public:
+
+            SweepIntervals() {}
+
+            // Intervals must outlive the sweep-line
+            template <typename I> SweepIntervals(I &x)
+            {
+                for (const auto &i : x.data())
+                {
+                    const auto t = x.find(i.first);
+                    _x.push_back(Node { t->l().start, t->l().end, 0, t });
+                }
+
+                std::sort(_x.begin(), _x.end(), [&](const Node &i, const Node &j)
+                {
+                    return before(i.t, j.t);
+                });
+
+                for (std::size_t i = 0; i < _x.size(); i++)
+                {
+                    _x[i].max = i ? std::max(_x[i-1].max, _x[i].end) : _x[i].end;
+                }
+            }
+
+            // Move to the start of the next alignment
+            inline void advance(Base pos)
+            {
+                if (pos >= _pos)
+                {
+                    while (_i < _x.size() && _x[_i].max < pos)
+                    {
+                        _i++;
+                    }
+                }
+                else
+                {
+                    _i = first(pos);
+                }
+
+                _pos = pos;
+            }
+
+            // The interval exactly matching the locus
+            inline T * exact(const Locus &l) const
+            {
+                auto i = std::lower_bound(_x.begin() + first(l.start), _x.end(), l.start, [&](const Node &x, Base s)
+                {
+                    return x.start < s;
+                });
+
+                for (; i != _x.end() && i->start == l.start; i++)
+                {
+                    if (i->end == l.end)
+                    {
+                        return i->t;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            // The interval containing the locus
+            inline T * contains(const Locus &l) const
+            {
+                for (auto i = first(l.start); i < _x.size() && _x[i].start <= l.start; i++)
+                {
+                    if (_x[i].end >= l.end)
+                    {
+                        return _x[i].t;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            // The interval overlapping the locus
+            inline T * overlap(const Locus &l) const
+            {
+                for (auto i = first(l.start); i < _x.size() && _x[i].start <= l.end; i++)
+                {
+                    if (_x[i].end >= l.start)
+                    {
+                        return _x[i].t;
+                    }
+                }
+
+                return nullptr;
+            }
+
+        private:
+
+            // The first interval that might end at or after the position
+            inline std::size_t first(Base pos) const
+            {
+                if (pos >= _pos)
+                {
+                    return _i;
+                }
+
+                return std::partition_point(_x.begin(), _x.end(), [&](const Node &x)
+                {
+                    return x.max < pos;
+                }) - _x.begin();
+            }
+
+            struct Node
+            {
+                Base start, end;
+
+                // Maximum end of the intervals up to here
+                Base max;
+
+                T *t;
+            };
+
+            std::vector<Node> _x;
+
+            // Cursor and the position it was moved to
+            std::size_t _i = 0;
+            Base _pos = 0;
+    };
+}
+
+#endif
@@ -74,6 +74,10 @@ typedef std::set<Value> Range;
 #define OPT_FILTER   819
 #define OPT_U_BED    820
 #define OPT_U_BASE   821
+#define OPT_SYN_ONLY 822
+#define OPT_U_OUT    823
+#define OPT_USE_IDX  824
+#define OPT_SEED     825
 
 using namespace Anaquin;
 
@@ -250,6 +254,8 @@ static const struct option long_options[] =
 
     { "writeUncalib", no_argument, 0, OPT_UN_CALIB },
     { "showReads",    no_argument, 0, OPT_READS    },
+    { "synOnly",      no_argument, 0, OPT_SYN_ONLY },
+    { "useIndex",     no_argument, 0, OPT_USE_IDX  },
 
     { "ubed",    required_argument, 0, OPT_U_BED    },
     { "usequin", required_argument, 0, OPT_U_SEQS   },
@@ -273,6 +279,9 @@ static const struct option long_options[] =
 
     { "edge",    required_argument, 0, OPT_EDGE   },
     { "fuzzy",   required_argument, 0, OPT_FUZZY  },
+
+    { "out",     required_argument, 0, OPT_U_OUT },
+    { "seed",    required_argument, 0, OPT_SEED  },
     
     { "o",       required_argument, 0, OPT_PATH },
 
@@ -491,6 +500,7 @@ template <typename Analyzer, typename F> void startAnalysis(F f, typename Analyz
     }
     
     o.work  = path;
+    o.thr   = _p.opts.count(OPT_THREAD) ? stoi(_p.opts.at(OPT_THREAD)) : 1;
     
     auto t  = std::time(nullptr);
     auto tm = *std::localtime(&t);
@@ -699,6 +709,43 @@ void parse(int argc, char ** argv)
 
         switch (opt)
         {
+            case OPT_THREAD:
+            {
+                auto n = 0;
+                
+                try
+                {
+                    n = stoi(val);
+                }
+                catch (...)
+                {
+                    throw std::runtime_error(val + " is not an integer. Please check and try again.");
+                }
+                
+                if (n <= 0)
+                {
+                    throw std::runtime_error("Invalid value for -threads. Number of threads must be greater than zero.");
+                }
+
+                _p.opts[opt] = val;
+                break;
+            }
+
+            case OPT_SEED:
+            {
+                try
+                {
+                    stoull(val);
+                    _p.opts[opt] = val;
+                }
+                catch (...)
+                {
+                    throw std::runtime_error(val + " is not an integer. Please check and try again.");
+                }
+
+                break;
+            }
+
             case OPT_EDGE:
             case OPT_FUZZY:
             {
@@ -756,7 +803,9 @@ void parse(int argc, char ** argv)
             case OPT_R_IND:
             case OPT_R_CON:
             case OPT_READS:
-            case OPT_THREAD:
+            case OPT_U_OUT:
+            case OPT_USE_IDX:
+            case OPT_SYN_ONLY:
             case OPT_UN_CALIB: { _p.opts[opt] = val; break; }
 
             case OPT_FILTER:
@@ -916,7 +965,14 @@ void parse(int argc, char ** argv)
 
             switch (_p.tool)
             {
-                case Tool::RnaAlign: { analyze_1<RAlign>(OPT_U_SEQS);    break; }
+                case Tool::RnaAlign:
+                {
+                    RAlign::Options o;
+                    o.synOnly = _p.opts.count(OPT_SYN_ONLY);
+                    analyze_1<RAlign>(OPT_U_SEQS, o);
+                    break;
+                }
+
                 case Tool::RnaAssembly:
                 {
                     RAssembly::Options o;
@@ -929,6 +985,9 @@ void parse(int argc, char ** argv)
                 {
                     RSample::Options o;
                     o.p = _p.sampled;
+                    o.out = _p.opts.count(OPT_U_OUT) ? _p.opts.at(OPT_U_OUT) : "";
+                    o.index = _p.opts.count(OPT_USE_IDX);
+                    o.seed  = _p.opts.count(OPT_SEED) ? stoull(_p.opts.at(OPT_SEED)) : 0;
                     analyze_1<RSample>(OPT_U_SEQS, o);
                     break;
                 }
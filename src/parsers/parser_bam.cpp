@@ -1,5 +1,10 @@
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #include <htslib/sam.h>
 #include "tools/samtools.hpp"
+#include "tools/ctpl_stl.h"
 #include "parsers/parser_bam.hpp"
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -12,12 +17,17 @@ void ParserBAM::Data::lName()
 
 void ParserBAM::Data::lSeq()
 {
-    seq = bam2seq(static_cast<bam1_t *>(_b));
+    bam2seq(static_cast<bam1_t *>(_b), seq);
 }
 
 void ParserBAM::Data::lQual()
 {
-    qual = bam2qual(static_cast<bam1_t *>(_b));
+    bam2qual(static_cast<bam1_t *>(_b), qual);
+}
+
+const char *ParserBAM::Data::chr() const
+{
+    return _tid >= 0 ? static_cast<bam_hdr_t *>(_h)->target_name[_tid] : "*";
 }
 
 bool ParserBAM::Data::nextCigar(Locus &l, bool &spliced)
@@ -96,16 +106,44 @@ bool ParserBAM::Data::nextCigar(Locus &l, bool &spliced)
     return false;
 }
 
-std::map<ChrID, Base> ParserBAM::header(const FileName &file)
+/*
+ * Handles released when they go out of scope, including when a functor throws
+ */
+
+struct CloseFile  { void operator()(samFile *x)   const { sam_close(x);       } };
+struct DestroyHdr { void operator()(bam_hdr_t *x) const { bam_hdr_destroy(x); } };
+struct DestroyRec { void operator()(bam1_t *x)    const { bam_destroy1(x);    } };
+struct DestroyItr { void operator()(hts_itr_t *x) const { hts_itr_destroy(x); } };
+
+typedef std::unique_ptr<samFile,   CloseFile>  FilePtr;
+typedef std::unique_ptr<bam_hdr_t, DestroyHdr> HdrPtr;
+typedef std::unique_ptr<bam1_t,    DestroyRec> RecPtr;
+typedef std::unique_ptr<hts_itr_t, DestroyItr> ItrPtr;
+
+// Open an alignment file and read the header
+static void openBAM(const FileName &file, FilePtr &f, HdrPtr &h)
 {
-    auto f = sam_open(file.c_str(), "r");
+    f.reset(sam_open(file.c_str(), "r"));
     
     if (!f)
     {
         throw std::runtime_error("Failed to open: " + file);
     }
+
+    h.reset(sam_hdr_read(f.get()));
     
-    auto h = sam_hdr_read(f);
+    if (!h)
+    {
+        throw std::runtime_error("Failed to read header: " + file);
+    }
+}
+
+std::map<ChrID, Base> ParserBAM::header(const FileName &file)
+{
+    FilePtr f;
+    HdrPtr  h;
+    
+    openBAM(file, f, h);
 
     std::map<ChrID, Base> c2b;
     
@@ -117,144 +155,596 @@ std::map<ChrID, Base> ParserBAM::header(const FileName &file)
     return c2b;
 }
 
-void ParserBAM::parse(const FileName &file, Functor x, bool details)
+/*
+ * Batch of decoded records. Batches are recycled between the reader thread and the
+ * consumer so that no record is allocated after start-up.
+ */
+
+struct Batch
 {
-    auto f = sam_open(file.c_str(), "r");
-    
-    if (!f)
+    Batch(std::size_t n)
     {
-        throw std::runtime_error("Failed to open: " + file);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            b.push_back(bam_init1());
+        }
     }
 
-    auto t = bam_init1();
-    auto h = sam_hdr_read(f);
+    ~Batch()
+    {
+        for (auto &i : b)
+        {
+            bam_destroy1(i);
+        }
+    }
 
-    Info info;
-    Data align;
+    std::vector<bam1_t *> b;
+
+    // Number of records in the batch
+    std::size_t n = 0;
+};
+
+/*
+ * Records are decoded on a dedicated thread while BGZF blocks are inflated by the htslib
+ * thread pool. The consumer gets the batches in the same order as they're read.
+ */
+
+class BatchReader
+{
+    public:
+
+        // Number of records for a batch
+        static const std::size_t N = 4096;
+    
+        // Number of batches in flight
+        static const std::size_t Q = 8;
+
+        BatchReader(samFile *f, bam_hdr_t *h) : _f(f), _h(h)
+        {
+            for (std::size_t i = 0; i < Q; i++)
+            {
+                _all.push_back(std::unique_ptr<Batch>(new Batch(N)));
+                _free.push(_all.back().get());
+            }
+
+            _t = std::thread(&BatchReader::read, this);
+        }
+
+        ~BatchReader()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_m);
+                _stop = true;
+            }
+
+            _c.notify_all();
+            _t.join();
+        }
+
+        // Next batch in the file, nullptr if the file is completed
+        Batch *next()
+        {
+            std::unique_lock<std::mutex> lock(_m);
+            _c.wait(lock, [&]() { return !_full.empty() || _done; });
+
+            if (_full.empty())
+            {
+                return nullptr;
+            }
+
+            auto x = _full.front();
+            _full.pop();
+
+            return x;
+        }
+
+        // Return the batch back to the reader
+        void recycle(Batch *x)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_m);
+                _free.push(x);
+            }
+
+            _c.notify_all();
+        }
+
+    private:
+
+        void read()
+        {
+            for (;;)
+            {
+                Batch *x;
 
-    while (sam_read1(f, h, t) >= 0)
+                {
+                    std::unique_lock<std::mutex> lock(_m);
+                    _c.wait(lock, [&]() { return !_free.empty() || _stop; });
+
+                    if (_stop)
+                    {
+                        break;
+                    }
+
+                    x = _free.front();
+                    _free.pop();
+                }
+
+                for (x->n = 0; x->n < x->b.size() && sam_read1(_f, _h, x->b[x->n]) >= 0; x->n++);
+
+                // Completed if the batch is not full
+                const auto done = x->n < x->b.size();
+
+                {
+                    std::lock_guard<std::mutex> lock(_m);
+
+                    if (x->n)
+                    {
+                        _full.push(x);
+                    }
+                    else
+                    {
+                        _free.push(x);
+                    }
+
+                    _done = done;
+                }
+
+                _c.notify_all();
+
+                if (done)
+                {
+                    break;
+                }
+            }
+        }
+
+        samFile   *_f;
+        bam_hdr_t *_h;
+
+        std::mutex _m;
+        std::condition_variable _c;
+
+        std::queue<Batch *> _free, _full;
+        std::vector<std::unique_ptr<Batch>> _all;
+
+        bool _stop = false;
+        bool _done = false;
+
+        std::thread _t;
+};
+
+void ParserBAM::fill(Data &align, Info &info, void *b, void *hdr, bool details)
+{
+    auto t = static_cast<bam1_t *>(b);
+    auto h = static_cast<bam_hdr_t *>(hdr);
+
+    info.length = t->core.tid >= 0 ? h->target_len[t->core.tid] : 0;
+
+    align.mapped = false;
+    //align.name   = bam_get_qname(t);
+
+    info.b = t;
+    info.h = h;
+
+    align._b  = t;
+    align._h  = h;
+
+    align.mapq = t->core.qual;
+    align.flag = t->core.flag;
+
+    const auto hasCID = t->core.tid >= 0;
+
+    #define isPairedEnd(b)    (((b)->core.flag&0x1)   != 0)
+    #define isAllAligned(b)   (((b)->core.flag&0x2)   != 0)
+    #define isUnmapped(b)     (((b)->core.flag&0x4)   != 0)
+    #define isMateUnmapped(b) (((b)->core.flag&0x8)   != 0)
+    #define isReversed(b)     (((b)->core.flag&0x10)  != 0)
+    #define isMateReversed(b) (((b)->core.flag&0x20)  != 0)
+    #define isFirstPair(b)    (((b)->core.flag&0x40)  != 0)
+    #define isLastPair(b)     (((b)->core.flag&0x80)  != 0)
+    #define isSecondary(b)    (((b)->core.flag&0x100) != 0)
+    #define isFailed(b)       (((b)->core.flag&0x200) != 0)
+    #define isDuplicate(b)    (((b)->core.flag&0x400) != 0)
+    #define isSupplement(b)   (((b)->core.flag&0x800) != 0)
+    #define isPrimary(b)      (((b)->core.flag&0x900) == 0)
+
+    align.isPaired      = isPairedEnd(t);
+    align.isAllAligned  = isAllAligned(t);
+    align.isAligned     = !isUnmapped(t);
+    align.isMateAligned = !isMateUnmapped(t);
+    align.isForward     = !isReversed(t);
+    align.isMateReverse = isMateReversed(t);
+    align.isFirstPair   = isFirstPair(t);
+    align.isSecondPair  = isLastPair(t);
+    align.isPassed      = !isFailed(t);
+    align.isDuplicate   = isDuplicate(t);
+    align.isSupplement  = isSupplement(t);
+    align.isPrimary     = isPrimary(t);
+    align.isSecondary   = isSecondary(t);
+
+    // Sorted alignments rarely change the chromosome, no string is built for the others
+    if (align.cID.empty() || t->core.tid != align._tid)
     {
-        info.length = h->target_len[t->core.tid];
+        align.cID = hasCID ? h->target_name[t->core.tid] : "*";
+    }
 
-        align.mapped = false;
-        //align.name   = bam_get_qname(t);
-        
-        info.b = t;
-        info.h = h;
+    align._tid = hasCID ? t->core.tid : -1;
 
-        align._b  = t;
-        align._h  = h;
+    if (!hasCID)
+    {
+        align.l.start = 0;
+        align.l.end = 0;
+    }
 
-        align.mapq = t->core.qual;
-        align.flag = t->core.flag;
-        
-        const auto hasCID = t->core.tid >= 0;
+    if (details)
+    {
+        //align.seq    = bam2seq(t);
+        //align.qual   = bam2qual(t);
+        //align.cigar  = hasCID ? bam2cigar(t) : "*";
+        align.tlen   = hasCID ? t->core.isize : 0;
+        align.pnext  = hasCID ? t->core.mpos : 0;
         
-        #define isPairedEnd(b)    (((b)->core.flag&0x1)   != 0)
-        #define isAllAligned(b)   (((b)->core.flag&0x2)   != 0)
-        #define isUnmapped(b)     (((b)->core.flag&0x4)   != 0)
-        #define isMateUnmapped(b) (((b)->core.flag&0x8)   != 0)
-        #define isReversed(b)     (((b)->core.flag&0x10)  != 0)
-        #define isMateReversed(b) (((b)->core.flag&0x20)  != 0)
-        #define isFirstPair(b)    (((b)->core.flag&0x40)  != 0)
-        #define isLastPair(b)     (((b)->core.flag&0x80)  != 0)
-        #define isSecondary(b)    (((b)->core.flag&0x100) != 0)
-        #define isFailed(b)       (((b)->core.flag&0x200) != 0)
-        #define isDuplicate(b)    (((b)->core.flag&0x400) != 0)
-        #define isSupplement(b)   (((b)->core.flag&0x800) != 0)
-        #define isPrimary(b)      (((b)->core.flag&0x900) == 0)
-
-        align.isPaired      = isPairedEnd(t);
-        align.isAllAligned  = isAllAligned(t);
-        align.isAligned     = !isUnmapped(t);
-        align.isMateAligned = !isMateUnmapped(t);
-        align.isForward     = !isReversed(t);
-        align.isMateReverse = isMateReversed(t);
-        align.isFirstPair   = isFirstPair(t);
-        align.isSecondPair  = isLastPair(t);
-        align.isPassed      = !isFailed(t);
-        align.isDuplicate   = isDuplicate(t);
-        align.isSupplement  = isSupplement(t);
-        align.isPrimary     = isPrimary(t);
-        align.isSecondary   = isSecondary(t);
-
-        if (hasCID)
+        // The same as bam2rnext() with "=" resolved, without building the strings for comparison
+        if (!hasCID)
+        {
+            align.rnext = "*";
+        }
+        else if (t->core.mtid < 0)
         {
-            align.cID = std::string(h->target_name[t->core.tid]);
+            align.rnext.clear();
         }
         else
         {
-            align.cID = "*";
-            align.l.start = 0;
-            align.l.end = 0;
+            align.rnext = h->target_name[t->core.mtid];
         }
+    }
+
+    align.mapped = hasCID && !(t->core.flag & BAM_FUNMAP);
+
+    if (align.mapped)
+    {
+        const auto cigar = bam_get_cigar(t);
 
-        if (details)
+        // Is this a multi alignment?
+        info.multi = t->core.n_cigar > 1;
+        info.end   = bam_endpos(t);
+
+        /*
+         * Quickly check the properties of the alignment
+         */
+    
+        info.ins  = false;
+        info.del  = false;
+        info.clip = false;
+        info.skip = false;
+    
+        for (uint32_t i = 0; i < t->core.n_cigar; i++)
         {
-            //align.seq    = bam2seq(t);
-            //align.qual   = bam2qual(t);
-            //align.cigar  = hasCID ? bam2cigar(t) : "*";
-            align.tlen   = hasCID ? t->core.isize : 0;
-            align.pnext  = hasCID ? t->core.mpos : 0;
-            align.rnext  = hasCID ? bam2rnext(h, t) : "*";
-            
-            if (align.rnext == "=")
+            switch (bam_cigar_op(cigar[i]))
             {
-                align.rnext = align.cID;
+                case BAM_CINS:       { info.ins  = true; break; }
+                case BAM_CDEL:       { info.del  = true; break; }
+                case BAM_CREF_SKIP:  { info.skip = true; break; }
+                case BAM_CSOFT_CLIP: { info.clip = true; break; }
+                case BAM_CHARD_CLIP: { info.clip = true; break; }
+                case BAM_CPAD:       { info.del  = true; break; }
+                default: { break; }
             }
         }
 
-        align.mapped = hasCID && !(t->core.flag & BAM_FUNMAP);
+        #define RESET_CIGAR { align._i = 0; align._n = t->core.pos; }
+    
+        RESET_CIGAR
+
+        bool spliced;
+        align.nextCigar(align.l, spliced);
+    
+        RESET_CIGAR
+    }
+}
+
+void ParserBAM::parse(const FileName &file, Functor x, bool details, unsigned thr)
+{
+    FilePtr f;
+    HdrPtr  h;
+    
+    openBAM(file, f, h);
+
+    Info info;
+    Data align;
+
+    if (thr <= 1)
+    {
+        RecPtr t(bam_init1());
+
+        while (sam_read1(f.get(), h.get(), t.get()) >= 0)
+        {
+            fill(align, info, t.get(), h.get(), details);
+            x(align, info);
+            info.p.i++;
+        }
+    }
+    else
+    {
+        // Decompressing BGZF blocks by the thread pool, one thread is reserved for decoding
+        hts_set_threads(f.get(), thr - 1);
+
+        // Must be destroyed before the file is closed
+        std::unique_ptr<BatchReader> r(new BatchReader(f.get(), h.get()));
+
+        for (Batch *b; (b = r->next());)
+        {
+            for (std::size_t i = 0; i < b->n; i++)
+            {
+                fill(align, info, b->b[i], h.get(), details);
+                x(align, info);
+                info.p.i++;
+            }
+
+            r->recycle(b);
+        }
+    }
+}
+
+void ParserBAM::parse(const FileName &file, Mapper m, Reducer r, bool details, unsigned thr)
+{
+    if (thr <= 1)
+    {
+        parse(file, [&](Data &x, const Info &info)
+        {
+            r(x, info, m(x, info));
+        }, details);
+
+        return;
+    }
 
-        if (align.mapped)
+    FilePtr f;
+    HdrPtr  h;
+    
+    openBAM(file, f, h);
+
+    // Batch being mapped by a worker
+    struct Slot
+    {
+        Batch *b = nullptr;
+        
+        std::vector<Data> d;
+        std::vector<Info> i;
+        std::vector<int>  r;
+        
+        std::future<void> f;
+    };
+    
+    // Decompressing BGZF blocks by the thread pool, the same number of threads for mapping
+    hts_set_threads(f.get(), thr - 1);
+
+    {
+        std::unique_ptr<BatchReader> reader(new BatchReader(f.get(), h.get()));
+
+        // Leave the rest of the batches for the reader
+        std::vector<Slot> slots(BatchReader::Q / 2);
+
+        // Must be destroyed before the slots and the reader
+        ctpl::thread_pool pool(thr - 1);
+
+        auto reduce = [&](Slot &s)
         {
-            const auto cigar = bam_get_cigar(t);
+            s.f.get();
+
+            for (std::size_t j = 0; j < s.b->n; j++)
+            {
+                r(s.d[j], s.i[j], s.r[j]);
+            }
 
-            // Is this a multi alignment?
-            info.multi = t->core.n_cigar > 1;
+            reader->recycle(s.b);
+            s.b = nullptr;
+        };
 
-            /*
-             * Quickly check the properties of the alignment
-             */
+        std::size_t k = 0, n = 0;
+        
+        for (Batch *b; (b = reader->next()); k++)
+        {
+            // The oldest batch in flight
+            auto &s = slots[k % slots.size()];
             
-            info.ins  = false;
-            info.del  = false;
-            info.clip = false;
-            info.skip = false;
+            if (s.b)
+            {
+                reduce(s);
+            }
+            
+            s.b = b;
+            s.d.resize(b->b.size());
+            s.i.resize(b->b.size());
+            s.r.resize(b->b.size());
+
+            auto x = &s;
             
-            for (auto i = 0; i < t->core.n_cigar; i++)
+            x->f = pool.push([&, x, n](int)
             {
-                switch (bam_cigar_op(cigar[i]))
+                for (std::size_t j = 0; j < x->b->n; j++)
                 {
-                    case BAM_CINS:       { info.ins  = true; break; }
-                    case BAM_CDEL:       { info.del  = true; break; }
-                    case BAM_CREF_SKIP:  { info.skip = true; break; }
-                    case BAM_CSOFT_CLIP: { info.clip = true; break; }
-                    case BAM_CHARD_CLIP: { info.clip = true; break; }
-                    case BAM_CPAD:       { info.del  = true; break; }
-                    default: { break; }
+                    fill(x->d[j], x->i[j], x->b->b[j], h.get(), details);
+                    x->i[j].p.i = n + j;
+                    x->r[j] = m(x->d[j], x->i[j]);
                 }
-            }
-
-            #define RESET_CIGAR { align._i = 0; align._n = t->core.pos; }
+            });
             
-            RESET_CIGAR
+            n += b->n;
+        }
 
-            bool spliced;
-            align.nextCigar(align.l, spliced);
-            
-            RESET_CIGAR
+        for (std::size_t j = 0; j < slots.size(); j++)
+        {
+            auto &s = slots[(k + j) % slots.size()];
             
-            x(align, info);
+            if (s.b)
+            {
+                reduce(s);
+            }
         }
-        else
+    }
+}
+
+bool ParserBAM::sorted(const FileName &file)
+{
+    auto f = sam_open(file.c_str(), "r");
+    
+    if (!f)
+    {
+        throw std::runtime_error("Failed to open: " + file);
+    }
+    
+    auto h = sam_hdr_read(f);
+    
+    if (!h)
+    {
+        throw std::runtime_error("Failed to read header: " + file);
+    }
+    
+    const auto text = std::string(h->text, h->l_text);
+    
+    bam_hdr_destroy(h);
+    sam_close(f);
+    
+    // Only the first line can be @HD
+    const auto line = text.substr(0, text.find('\n'));
+
+    return line.compare(0, 3, "@HD") == 0 && line.find("\tSO:coordinate") != std::string::npos;
+}
+
+bool ParserBAM::indexed(const FileName &file)
+{
+    auto f = sam_open(file.c_str(), "r");
+    
+    if (!f)
+    {
+        throw std::runtime_error("Failed to open: " + file);
+    }
+    
+    // Looking for .bai or .csi
+    auto i = sam_index_load(f, file.c_str());
+    
+    const auto r = i != nullptr;
+
+    if (i)
+    {
+        hts_idx_destroy(i);
+    }
+
+    sam_close(f);
+    return r;
+}
+
+std::map<ChrID, ParserBAM::IndexStats> ParserBAM::indexStats(const FileName &file)
+{
+    auto f = sam_open(file.c_str(), "r");
+    
+    if (!f)
+    {
+        throw std::runtime_error("Failed to open: " + file);
+    }
+    
+    auto h = sam_hdr_read(f);
+    auto i = sam_index_load(f, file.c_str());
+    
+    if (!i)
+    {
+        throw std::runtime_error("Failed to load index for: " + file);
+    }
+
+    std::map<ChrID, IndexStats> r;
+    
+    for (auto j = 0; j < h->n_targets; j++)
+    {
+        uint64_t mapped, unmapped;
+        
+        if (hts_idx_get_stat(i, j, &mapped, &unmapped) >= 0)
         {
-            x(align, info);
+            r[h->target_name[j]].mapped   = mapped;
+            r[h->target_name[j]].unmapped = unmapped;
+        }
+    }
+    
+    r["*"].unmapped = hts_idx_get_n_no_coor(i);
+
+    hts_idx_destroy(i);
+    bam_hdr_destroy(h);
+    sam_close(f);
+    
+    return r;
+}
+
+ParserBAM::Indexed::Indexed(const FileName &file) : _file(file)
+{
+    auto f = sam_open(file.c_str(), "r");
+    
+    if (!f)
+    {
+        throw std::runtime_error("Failed to open: " + file);
+    }
+
+    auto h = sam_hdr_read(f);
+    auto i = h ? sam_index_load(f, file.c_str()) : nullptr;
+
+    if (!i)
+    {
+        if (h)
+        {
+            bam_hdr_destroy(h);
         }
         
+        sam_close(f);
+        throw std::runtime_error("Failed to load index for: " + file);
+    }
+    
+    _f = f;
+    _h = h;
+    _i = i;
+}
+
+ParserBAM::Indexed::~Indexed()
+{
+    hts_idx_destroy(static_cast<hts_idx_t *>(_i));
+    bam_hdr_destroy(static_cast<bam_hdr_t *>(_h));
+    sam_close(static_cast<samFile *>(_f));
+}
+
+void ParserBAM::Indexed::parse(const ChrID &cID, const Locus &l, Functor x, bool details)
+{
+    auto f = static_cast<samFile *>(_f);
+    auto h = static_cast<bam_hdr_t *>(_h);
+    auto i = static_cast<hts_idx_t *>(_i);
+
+    const auto tid = cID == "*" ? HTS_IDX_NOCOOR : bam_name2id(h, cID.c_str());
+
+    if (tid == -1)
+    {
+        throw std::runtime_error("Chromosome: [" + cID + "] can't be found in: " + _file);
+    }
+
+    // The index works with 0-based half-open coordinates
+    ItrPtr r(sam_itr_queryi(i, tid, l.start - 1, l.end));
+    
+    Info info;
+    Data align;
+
+    RecPtr t(bam_init1());
+
+    while (r && sam_itr_next(f, r.get(), t.get()) >= 0)
+    {
+        // Alignments starting before the region belong to the previous region
+        if (tid != HTS_IDX_NOCOOR && t->core.pos < l.start - 1)
+        {
+            continue;
+        }
+
+        fill(align, info, t.get(), h, details);
+        x(align, info);
         info.p.i++;
     }
+}
 
-    bam_destroy1(t);
-    sam_close(f);
+void ParserBAM::parse(const FileName &file, const ChrID &cID, const Locus &l, Functor x, bool details)
+{
+    Indexed(file).parse(cID, l, x, details);
 }
@@ -30,6 +30,9 @@ namespace Anaquin
             
             // Size of the chromosome of the alignment
             Base length;
+
+            // Last position of a mapped alignment (1-based), including all the blocks
+            Base end;
             
             void *b;
             void *h;
@@ -59,10 +62,23 @@ namespace Anaquin
                 inline void *b() const { return _b; }
                 inline void *h() const { return _h; }
 
+                /*
+                 * Index of the chromosome in the header, negative if no coordinate. Per-chromosome
+                 * state can be indexed by this rather than cID.
+                 */
+            
+                inline int tid() const { return _tid; }
+
+                // Name of the chromosome without copying, valid until the next alignment
+                const char *chr() const;
+
             private:
             
                 mutable int _i, _n;
 
+                // cID is only updated when the chromosome changes
+                int _tid = -1;
+
                 void *_b;
                 void *_h;
         };
@@ -72,11 +88,82 @@ namespace Anaquin
         static std::map<ChrID, Base> header(const FileName &);
         
         /*
-         * In order to improve the efficiency, not everything is computed. Set the last
-         * argument to true will force it to happen.
+         * In order to improve the efficiency, not everything is computed. Set the details
+         * argument to true will force it to happen. With more than one thread, BGZF blocks
+         * are decompressed in parallel and the records are still given in the file order.
          */
 
-        static void parse(const FileName &, Functor, bool details = false);
+        static void parse(const FileName &, Functor, bool details = false, unsigned thr = 1);
+
+        // Called by the workers, the result is given to the reducer
+        typedef std::function<int (Data &, const Info &)> Mapper;
+
+        // Called in the file order by the calling thread
+        typedef std::function<void (Data &, const Info &, int)> Reducer;
+
+        /*
+         * Records are partitioned by batches across the worker threads, which decode and map them
+         * concurrently (the mapper must be thread-safe). The results are reduced in the file order,
+         * thus the output doesn't depend on the number of threads.
+         */
+
+        static void parse(const FileName &, Mapper, Reducer, bool details = false, unsigned thr = 1);
+
+        // Whether the alignment file is sorted by coordinate (@HD SO:coordinate)
+        static bool sorted(const FileName &);
+
+        // Whether the alignment file has an index (.bai or .csi)
+        static bool indexed(const FileName &);
+
+        struct IndexStats
+        {
+            // Number of mapped alignments (secondary and supplementary alignments included)
+            Counts mapped = 0;
+            
+            // Number of unmapped alignments
+            Counts unmapped = 0;
+        };
+
+        // Counts for each chromosome by the index, "*" for unmapped alignments without coordinate
+        static std::map<ChrID, IndexStats> indexStats(const FileName &);
+
+        /*
+         * Parse alignments starting within a region by the index. Every alignment is given by exactly
+         * one of the non-overlapping regions. Unmapped alignments without coordinate are given by "*".
+         */
+
+        static void parse(const FileName &, const ChrID &, const Locus &, Functor, bool details = false);
+
+        /*
+         * Indexed alignment file opened once for many region queries, such as a worker in the
+         * sharded mode. Not thread-safe, each thread should have its own.
+         */
+
+        class Indexed
+        {
+            public:
+
+                Indexed(const FileName &);
+                ~Indexed();
+
+                Indexed(const Indexed &) = delete;
+                Indexed &operator=(const Indexed &) = delete;
+
+                // Same as ParserBAM::parse for a region
+                void parse(const ChrID &, const Locus &, Functor, bool details = false);
+
+            private:
+
+                FileName _file;
+
+                void *_f;
+                void *_h;
+                void *_i;
+        };
+
+        private:
+
+            static void fill(Data &, Info &, void *, void *, bool);
     };
 }
 
@@ -79,9 +79,15 @@ namespace Anaquin
                 // Segment sequence (optional)
                 inline std::string seq() { return bam2seq(static_cast<bam1_t *>(_b)); }
 
+                // Segment sequence into a reusable buffer (optional)
+                inline void seq(std::string &r) { bam2seq(static_cast<bam1_t *>(_b), r); }
+
                 // ASCII of base QUALity (optional)
                 inline std::string qual() { return bam2qual(static_cast<bam1_t *>(_b)); }
 
+                // ASCII of base QUALity into a reusable buffer (optional)
+                inline void qual(std::string &r) { bam2qual(static_cast<bam1_t *>(_b), r); }
+
                 bool nextCigar(Locus &);
             
                 inline void *b() const { return _b; }
@@ -29,7 +29,8 @@ namespace Anaquin
         
         template <typename F> static ParserBAMBED::Stats parse(const FileName &file,
                                                                const Chr2DInters &c2l,
-                                                               F f)
+                                                               F f,
+                                                               unsigned thr = 1)
         {
             ParserBAMBED::Stats stats;
 
@@ -48,13 +49,32 @@ namespace Anaquin
                 stats.inters[i.first].build();
             }
 
+            // Intervals for each chromosome in the header, resolved on the first alignment
+            std::vector<std::pair<bool, DIntervals<> *>> tids;
+            
             ParserBAM::parse(file, [&](ParserBAM::Data &x, const ParserBAM::Info &info)
             {
                 DInter *matched = nullptr;
                 
-                if (x.mapped && stats.inters.count(x.cID))
+                if (x.mapped)
                 {
-                    matched = stats.inters[x.cID].overlap(x.l);
+                    if (static_cast<std::size_t>(x.tid()) >= tids.size())
+                    {
+                        tids.resize(x.tid() + 1);
+                    }
+                    
+                    auto &t = tids[x.tid()];
+                    
+                    if (!t.first)
+                    {
+                        const auto i = stats.inters.find(x.cID);
+                        t = std::make_pair(true, i != stats.inters.end() ? &i->second : nullptr);
+                    }
+                    
+                    if (t.second)
+                    {
+                        matched = t.second->firstOverlap(x.l);
+                    }
                 }
                 
                 const auto r = f(x, info, matched);
@@ -79,7 +99,7 @@ namespace Anaquin
                         stats.nNA++;
                     }
                 }
-            });
+            }, false, thr);
             
             return stats;
         }
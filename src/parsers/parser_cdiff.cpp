@@ -32,10 +32,10 @@ bool ParserCDiff::isCDiff(const Reader &r, unsigned &nTrans, unsigned &nGenes)
             const auto &rs = Standard::instance().r_rna;
             
             // Sequin transcripts
-            const auto &l1 = rs.seqsL1();
+            const auto &l1 = rs.namesL1();
             
             // Sequin genes
-            const auto &l2 = rs.seqsL2();
+            const auto &l2 = rs.namesL2();
 
             nTrans = nGenes = 0;
             
@@ -87,7 +87,7 @@ namespace Anaquin
                     
                     if (x.cID == "-")
                     {
-                        x.cID = r.seqsL1().count(x.iID) || r.seqsL2().count(x.gID) ? ChrIS() : "endo";
+                        x.cID = r.namesL1().count(x.iID) || r.namesL2().count(x.gID) ? ChrIS() : "endo";
                         std::cout << x.gID << std::endl;
                     }
 
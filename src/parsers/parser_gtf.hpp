@@ -1,6 +1,8 @@
 #ifndef PARSER_GTF_HPP
 #define PARSER_GTF_HPP
 
+#include <cstring>
+#include <algorithm>
 #include "data/tokens.hpp"
 #include "data/reader.hpp"
 #include "tools/tools.hpp"
@@ -32,16 +34,10 @@ namespace Anaquin
             double fpkm = NAN;
         };
         
+        // The functor gets the line as a view, valid until the next line
         template <typename F> static void parse(const Reader &r, F f)
         {
-            std::map<std::string, RNAFeature> mapper =
-            {
-                { "exon",       RNAFeature::Exon },
-                { "gene",       RNAFeature::Gene },
-                { "transcript", RNAFeature::Transcript }
-            };
-            
-            std::string line;
+            LineView l;
             Data x;
             
             /*
@@ -57,82 +53,208 @@ namespace Anaquin
              *    7. strand
              *    8. frame
              *    9. attribute
+             *
+             * The fields are scanned in place, only the values we need are copied. The line is only copied for errors.
              */
             
             ParserProgress p;
+
+            // Fields of the line, [begin, end) for each
+            const char *b[9], *e[9];
             
-            std::vector<std::string> opts;
-            std::vector<std::string> toks;
-            std::vector<std::string> nameVal;
-            
-            while (r.nextLine(line))
+            while (r.nextLine(l))
             {
                 p.i++;
-                boost::split(toks, line, boost::is_any_of("\t"));
+                
+                std::size_t n = 0;
+                
+                const auto end = l.s + l.n;
+                
+                for (const char *i = l.s; n < 9; i++)
+                {
+                    b[n] = i;
+                    
+                    // The last field takes everything left
+                    for (; i < end && (*i != '\t' || n == 8); i++);
+                    
+                    e[n++] = i;
+
+                    if (i == end)
+                    {
+                        break;
+                    }
+                }
                 
                 // Empty line? Unknown feature such as mRNA?
-                if (toks.size() == 1 || !mapper.count(toks[2]))
+                if (n < 3 || !feature(b[2], e[2], x.type))
                 {
                     continue;
                 }
+                else if (n < 9)
+                {
+                    throw std::runtime_error("File: " + r.src() + ". Invalid line: " + l.str());
+                }
                 
-                x.cID  = toks[0];
-                x.type = mapper[toks[2]];
+                x.cID.assign(b[0], e[0]);
 
-                x.l.start = stoi(toks[3]);
-                x.l.end   = stoi(toks[4]);
+                x.l.start = toBase(b[3], e[3]);
+                x.l.end   = toBase(b[4], e[4]);
 
-                if (toks[6] != "+" && toks[6] != "-" && toks[6] != ".")
+                switch (e[6] - b[6] == 1 ? *b[6] : 0)
                 {
-                    throw std::runtime_error("File: " + r.src() + ". Invalid strand: [" + toks[6] + "]. Line: " + line );
-                }
+                    case '+': { x.str = Strand::Forward;  break; }
+                    case '-': { x.str = Strand::Backward; break; }
+                    case '.': { x.str = Strand::Either;   break; }
 
-                if (toks[6] == ".")
-                {
-                    x.str = Strand::Either;
-                }
-                else
-                {
-                    x.str = toks[6] == "+" ? Strand::Forward : Strand::Backward;
+                    default:
+                    {
+                        throw std::runtime_error("File: " + r.src() + ". Invalid strand: [" + std::string(b[6], e[6]) + "]. Line: " + l.str());
+                    }
                 }
 
                 /*
                  * Eg: "gene_id "R_5_3"; transcript_id "R_5_3_R";"
                  */
                 
-                boost::split(opts, toks[8], boost::is_any_of(";"));
-                
-                for (auto option : opts)
+                for (auto i = b[8]; i < e[8];)
                 {
-                    if (!option.empty())
+                    // Name of the attribute
+                    for (; i < e[8] && (*i == ' ' || *i == ';'); i++);
+                    const auto nb = i;
+                    for (; i < e[8] && *i != ' ' && *i != ';'; i++);
+                    const auto ne = i;
+                    
+                    // Value of the attribute, quoted or not
+                    for (; i < e[8] && *i == ' '; i++);
+                    
+                    const char *vb, *ve;
+                    
+                    if (i < e[8] && *i == '"')
+                    {
+                        for (vb = ++i; i < e[8] && *i != '"'; i++);
+                        ve = i;
+                    }
+                    else
+                    {
+                        for (vb = i; i < e[8] && *i != ' ' && *i != ';'; i++);
+                        ve = i;
+                    }
+
+                    // Move to the next attribute
+                    for (; i < e[8] && *i != ';'; i++);
+
+                    if (nb == ne || vb == ve)
+                    {
+                        continue;
+                    }
+                    else if (isAttr(nb, ne, "gene_id"))
+                    {
+                        x.gID.assign(vb, ve);
+                    }
+                    else if (isAttr(nb, ne, "transcript_id"))
+                    {
+                        x.tID.assign(vb, ve);
+                    }
+                    else if (isAttr(nb, ne, "FPKM"))
                     {
-                        boost::trim(option);
-                        boost::split(nameVal, option, boost::is_any_of(" "));
-                        
-                        if (nameVal.size() == 2)
-                        {
-                            // Make sure the silly characters are removed
-                            nameVal[1].erase(std::remove(nameVal[1].begin(), nameVal[1].end(), '\"'), nameVal[1].end());
-                            
-                            if (nameVal[0] == "gene_id")
-                            {
-                                x.gID = nameVal[1];
-                            }
-                            else if (nameVal[0] == "transcript_id")
-                            {
-                                x.tID = nameVal[1];
-                            }
-                            else if (nameVal[0] == "FPKM")
-                            {
-                                x.fpkm = s2d(nameVal[1]);
-                            }
-                        }
+                        x.fpkm = s2d(std::string(vb, ve));
                     }
                 }
 
-                f(x, line, p);
+                f(x, l, p);
             }            
         }
+
+        // Records on a chromosome and the rest, the lines are kept as they're
+        struct Split
+        {
+            std::string chr, rest;
+        };
+
+        /*
+         * Split the records by the chromosome in a single read, only the first field is parsed. Records on
+         * the chromosome with any of the keywords are skipped. Comments and empty lines are dropped.
+         */
+
+        static Split split(const Reader &r, const ChrID &cID, const std::vector<std::string> &skip = {})
+        {
+            Split x;
+            LineView l;
+
+            while (r.nextLine(l))
+            {
+                if (!l.n || l.s[0] == '#')
+                {
+                    continue;
+                }
+
+                const auto t = static_cast<const char *>(memchr(l.s, '\t', l.n));
+                const auto n = t ? std::size_t(t - l.s) : l.n;
+
+                if (n == cID.size() && !memcmp(l.s, cID.data(), n))
+                {
+                    const auto isSkip = std::any_of(skip.begin(), skip.end(), [&](const std::string &i)
+                    {
+                        return std::search(l.s, l.s + l.n, i.begin(), i.end()) != l.s + l.n;
+                    });
+
+                    if (!isSkip)
+                    {
+                        x.chr.append(l.s, l.n).push_back('\n');
+                    }
+                }
+                else
+                {
+                    x.rest.append(l.s, l.n).push_back('\n');
+                }
+            }
+
+            return x;
+        }
+
+        private:
+
+            template <std::size_t N> static bool isAttr(const char *b, const char *e, const char (&x)[N])
+            {
+                return e - b == N - 1 && !memcmp(b, x, N - 1);
+            }
+
+            static bool feature(const char *b, const char *e, RNAFeature &x)
+            {
+                if      (isAttr(b, e, "exon"))       { x = RNAFeature::Exon;       }
+                else if (isAttr(b, e, "gene"))       { x = RNAFeature::Gene;       }
+                else if (isAttr(b, e, "transcript")) { x = RNAFeature::Transcript; }
+                else                                 { return false; }
+
+                return true;
+            }
+
+            // The same as stoi() without building a string
+            static Base toBase(const char *b, const char *e)
+            {
+                for (; b < e && isspace(*b); b++);
+
+                const auto neg = b < e && *b == '-';
+                
+                if (b < e && (*b == '-' || *b == '+'))
+                {
+                    b++;
+                }
+                
+                if (b == e || !isdigit(*b))
+                {
+                    throw std::invalid_argument("stoi");
+                }
+                
+                Base x = 0;
+                
+                for (; b < e && isdigit(*b); b++)
+                {
+                    x = 10 * x + (*b - '0');
+                }
+                
+                return neg ? -x : x;
+            }
     };
 }
 
@@ -154,7 +154,8 @@ namespace Anaquin
 
     struct AnalyzerOptions : public WriterOptions
     {
-        // Empty Implementation
+        // Number of threads (-threads)
+        unsigned thr = 1;
     };
 
     struct FuzzyOptions : public AnalyzerOptions
@@ -1,8 +1,13 @@
 #ifndef GTF_DATA_HPP
 #define GTF_DATA_HPP
 
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "data/hist.hpp"
+#include "data/names.hpp"
 #include "tools/tools.hpp"
+#include "tools/random.hpp"
 #include "data/dinters.hpp"
 #include "RnaQuin/RnaQuin.hpp"
 #include "parsers/parser_gtf.hpp"
@@ -12,219 +17,253 @@ extern void printWarning(const std::string &);
 
 namespace Anaquin
 {
-    struct ExonData
+    /*
+     * A row for genes, transcripts, exons or introns. Names are indexes to the string tables, the
+     * transcript is unused for genes.
+     */
+
+    struct Feature
     {
-        operator const Locus &() const { return l; }
-        
-        inline bool operator<(const  ExonData &x) const { return l < x.l;  }
-        inline bool operator==(const ExonData &x) const { return l == x.l; }
-        inline bool operator!=(const Locus &l)    const { return !operator==(l); }
-        inline bool operator==(const Locus &l)    const
-        {
-            return this->l.start == l.start && this->l.end == l.end;
-        }
-        
-        inline void operator+=(const ExonData &x)
+        inline Locus l() const { return Locus(start, end); }
+
+        inline bool operator<(const Feature &x) const
         {
-            l.start = std::min(l.start, x.l.start);
-            l.end   = std::max(l.end, x.l.end);
+            return start < x.start || (start == x.start && end < x.end);
         }
 
         inline bool isForward()  const { return str == Strand::Forward;  }
         inline bool isBackward() const { return str == Strand::Backward; }
-        
+
         // Eg: chr1
-        ChrID cID;
-        
+        NameID c;
+
         // Eg: ENSG00000223972.5
-        GeneID gID;
-        
+        NameID g;
+
         // Eg: ENST00000456328.2
-        TransID tID;
-        
+        NameID t;
+
         Strand str;
-        
-        Locus l;
-    };
-    
-    struct TransData
-    {
-        // Eg: chr1
-        ChrID cID;
-        
-        // Eg: ENSG00000223972.5
-        GeneID gID;
-        
-        // Eg: ENST00000456328.2
-        TransID tID;
-        
-        Locus l;
+
+        Base start, end;
     };
-    
-    struct GeneData
+
+    /*
+     * Rows sorted by the chromosomes, the rows for the i-th chromosome are [o[i], o[i+1]).
+     */
+
+    struct Features
     {
-        // Eg: chr1
-        ChrID cID;
-        
-        // Eg: ENSG00000223972.5
-        GeneID gID;
-        
-        Locus l;
+        struct Rows
+        {
+            inline const Feature *begin() const { return b; }
+            inline const Feature *end()   const { return e; }
+            inline Counts size() const { return e - b; }
+
+            const Feature *b, *e;
+        };
+
+        Features() {}
+
+        // Rows must have been sorted by the chromosomes, they are taken over
+        Features(std::vector<Feature> &&x, std::size_t n) : x(std::move(x)), o(n + 1, 0)
+        {
+            for (const auto &i : this->x)
+            {
+                o[i.c + 1]++;
+            }
+
+            for (std::size_t i = 1; i <= n; i++)
+            {
+                o[i] += o[i-1];
+            }
+        }
+
+        inline Rows rows(NameID c) const
+        {
+            return Rows { x.data() + o[c], x.data() + o[c+1] };
+        }
+
+        inline Counts size(NameID c) const { return o[c+1] - o[c]; }
+
+        std::vector<Feature> x;
+        std::vector<std::size_t> o;
     };
 
-    typedef ExonData IntronData;
-    
-    struct ChrData
+    /*
+     * Interval sets built on the first request, shared by the analyzers and the report writers. A copy
+     * starts empty, thus the sets always belong to the annotation they're built from.
+     */
+
+    class IntersMemo
     {
-        // Transcripts to Data
-        std::map<TransID, TransData> t2d;
-        
-        // Genes to Data
-        std::map<GeneID, GeneData> g2d;
-        
-        // Transcripts to non-unique exons
-        std::map<TransID, std::set<ExonData>> t2e;
-        
-        // Transcripts to unique exons
-        std::map<TransID, std::set<ExonData>> t2ue;
-
-        // Transcripts to unique introns
-        std::map<TransID, std::set<IntronData>> t2ui;
-        
-        // Transcripts to genes
-        std::map<TransID, GeneID> t2g;
-        
-        // Unique exons (forwards + backwards)
-        Counts uexons = 0;
-
-        // Unique introns (forwards + backwards)
-        Counts uintrs = 0;
-        
-        std::set<GeneID> gIDs;
+        public:
+
+            IntersMemo() {}
+            IntersMemo(const IntersMemo &) {}
+
+            // References given by get() are invalidated, like anything else of the assigned annotation
+            inline IntersMemo &operator=(const IntersMemo &)
+            {
+                std::lock_guard<std::recursive_mutex> l(_m);
+
+                g.clear();
+                c2m.clear();
+
+                return *this;
+            }
+
+            // Built by the function unless it's already there
+            template <typename M, typename F> const typename M::mapped_type &get(M &x, const typename M::key_type &k, F f)
+            {
+                std::lock_guard<std::recursive_mutex> l(_m);
+
+                auto i = x.find(k);
+
+                if (i == x.end())
+                {
+                    i = x.insert(std::make_pair(k, f())).first;
+                }
+
+                return i->second;
+            }
+
+            // Copy of everything built so far, other threads might be building at the same time
+            template <typename M> M snapshot(const M &x)
+            {
+                std::lock_guard<std::recursive_mutex> l(_m);
+                return x;
+            }
+
+            // Genes for each chromosome
+            std::map<ChrID, DIntervals<>> g;
+
+            // Eg: merged exons for a strand
+            std::map<std::pair<RNAFeature, Strand>, Chr2MInters> c2m;
+
+        private:
+
+            std::recursive_mutex _m;
     };
-    
-    struct GTFData : public std::map<ChrID, ChrData>
+
+    /*
+     * Columnar representation for an annotation. Names are interned, genes, transcripts, unique exons
+     * and unique introns are flat arrays. Within a chromosome, genes are sorted by the names, the others
+     * by the transcript names and then the positions.
+     */
+
+    struct GTFData
     {
+        // Chromosomes in sorted order
+        inline std::vector<ChrID> chrs() const
+        {
+            std::vector<ChrID> r;
+
+            for (NameID i = 0; i < cIDs.size(); i++)
+            {
+                r.push_back(cIDs[i]);
+            }
+
+            std::sort(r.begin(), r.end());
+            return r;
+        }
+
         // Genes for a chromosome
         inline std::set<GeneID> genes(const ChrID &x) const
         {
             std::set<GeneID> r;
-            
-            for (const auto &i : at(x).g2d)
+
+            for (const auto &i : gs.rows(cIDs.at(x)))
             {
-                r.insert(i.first);
+                r.insert(gIDs[i.g]);
             }
-            
+
             return r;
         }
-        
+
         // Genes for all chromosome
         inline std::map<ChrID, std::set<GeneID>> genes() const
         {
             std::map<ChrID, std::set<GeneID>> r;
-            
-            for (const auto &i : *this)
+
+            for (NameID i = 0; i < cIDs.size(); i++)
             {
-                r[i.first] = genes(i.first);
+                r[cIDs[i]] = genes(cIDs[i]);
             }
-            
+
             return r;
         }
-        
+
         inline Counts nGene() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return nGene(cID);
-            });
+            return std::accumulate(c2g.begin(), c2g.end(), Counts(0));
         }
-        
+
         inline Counts countTrans() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return countTrans(cID);
-            });
+            return ts.x.size();
         }
-        
+
         inline Counts countUExon() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return countUExon(cID);
-            });
+            return ues.x.size();
         }
 
         inline Counts countUIntr() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return countUIntr(cID);
-            });
+            return uis.x.size();
         }
-        
+
         inline Counts nGene(const ChrID &cID) const
         {
-            return at(cID).gIDs.size();
+            return c2g.at(cIDs.at(cID));
         }
-        
+
         inline Counts countTrans(const ChrID &cID) const
         {
-            return at(cID).t2d.size();
+            return ts.size(cIDs.at(cID));
         }
-        
+
         inline Counts countUExon(const ChrID &cID) const
         {
-            return at(cID).uexons;
+            return ues.size(cIDs.at(cID));
         }
-        
+
         inline Counts countUIntr(const ChrID &cID) const
         {
-            return at(cID).uintrs;
+            return uis.size(cIDs.at(cID));
         }
 
         inline Counts nGeneSyn() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return isChrIS(cID) ? nGene(cID) : 0;
-            });
+            return countSyn([&](const ChrID &cID) { return nGene(cID); });
         }
-        
+
         inline Counts countTransSyn() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return isChrIS(cID) ? countTrans(cID) : 0;
-            });
+            return countSyn([&](const ChrID &cID) { return countTrans(cID); });
         }
-        
+
         inline Counts countUExonSyn() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return isChrIS(cID) ? countUExon(cID) : 0;
-            });
+            return countSyn([&](const ChrID &cID) { return countUExon(cID); });
         }
-        
+
         inline Counts countUIntrSyn() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return isChrIS(cID) ? countUIntr(cID) : 0;
-            });
+            return countSyn([&](const ChrID &cID) { return countUIntr(cID); });
         }
 
         inline Counts nGeneGen() const
         {
             return nGene() - nGeneSyn();
         }
-        
+
         inline Counts countTransGen() const
         {
             return countTrans() - countTransSyn();
         }
-        
+
         inline Counts countUExonGen() const
         {
             return countUExon() - countUExonSyn();
@@ -234,88 +273,93 @@ namespace Anaquin
         {
             return countUIntr() - countUIntrSyn();
         }
-        
-        inline DIntervals<> gIntervals(const ChrID &cID) const
+
+        // Intervals for the genes of a chromosome (built once)
+        inline const DIntervals<> &gIntervals(const ChrID &cID) const
         {
-            DIntervals<> r;
-            
-            for (const auto &i : at(cID).g2d)
+            return _memo.get(_memo.g, cID, [&]() -> DIntervals<>
             {
-                r.add(DInter(i.first, i.second.l));
-            }
-            
-            r.build();
-            return r;
+                DIntervals<> r;
+
+                for (const auto &i : gs.rows(cIDs.at(cID)))
+                {
+                    r.add(DInter(gIDs[i.g], i.l()));
+                }
+
+                r.build();
+                return r;
+            });
         }
-        
+
+        // Intervals for the genes of all chromosomes (built once), copied as the memo might be growing
         inline std::map<ChrID, DIntervals<>> gIntervals() const
         {
-            std::map<ChrID, DIntervals<>> r;
-            
-            for (const auto &i : *this)
+            for (NameID i = 0; i < cIDs.size(); i++)
             {
-                r[i.first] = gIntervals(i.first);
+                gIntervals(cIDs[i]);
             }
 
-            return r;
+            return _memo.snapshot(_memo.g);
         }
-        
-        // Intervals for merged exons
-        inline Chr2MInters meInters(Strand str) const
+
+        // Intervals for merged exons (built once)
+        inline const Chr2MInters &meInters(Strand str) const
         {
-            Chr2MInters r;
-            
-            for (const auto &i : *this)
+            return _memo.get(_memo.c2m, std::make_pair(RNAFeature::Exon, str), [&]() -> Chr2MInters
             {
-                r[i.first] = meInters(i.first, str);
-            }
-            
-            return r;
+                Chr2MInters r;
+
+                for (NameID i = 0; i < cIDs.size(); i++)
+                {
+                    r[cIDs[i]] = meInters(cIDs[i], str);
+                }
+
+                return r;
+            });
         }
-        
+
         // Intervals for merged exons (only possible at the gene level)
         inline MergedIntervals<> meInters(const ChrID &cID, Strand str) const
         {
             MergedIntervals<> r;
 
             // This is needed to merge exons over all transcripts
-            std::map<GeneID, MergedInterval> merged;
-            
-            // For each transcript...
-            for (const auto &i : at(cID).t2ue)
+            std::unordered_map<NameID, MergedInterval> merged;
+
+            // Transcript not matching the strand
+            auto skip = std::numeric_limits<NameID>::max();
+
+            // For each exon (grouped by transcripts)...
+            for (const auto &i : ues.rows(cIDs.at(cID)))
             {
-                const auto &tID = i.first;
-                const auto &gID = at(cID).t2g.at(tID);
+                auto j = merged.find(i.g);
 
-                if (!merged.count(gID))
+                if (j == merged.end())
                 {
                     // Merging unique exons (doesn't matter how long this is)
-                    merged[gID] = MergedInterval(gID, Locus(1, std::numeric_limits<Base>::max()));
+                    j = merged.insert(std::make_pair(i.g, MergedInterval(gIDs[i.g], Locus(1, std::numeric_limits<Base>::max())))).first;
                 }
-                
-                // For each exon in the transcript...
-                for (const auto &j : i.second)
-                {
-                    if (str != Strand::Either && (j.str != str))
-                    {
-                        break;
-                    }
 
-                    // Merge all the overlapping exons
-                    merged.at(gID).map(j.l);
+                // The rest of the transcript is ignored once the strand doesn't match
+                if (i.t == skip || (str != Strand::Either && i.str != str))
+                {
+                    skip = i.t;
+                    continue;
                 }
+
+                // Merge all the overlapping exons
+                j->second.add(i.l());
             }
-            
+
             // For each gene in the chromosome...
             for (const auto &i : merged)
             {
-                const auto &gID = i.first;
+                const auto &gID = gIDs[i.first];
 
                 // For each merged exon in the gene...
-                for (const auto &j : i.second._data)
+                for (const auto &l : i.second.runs())
                 {
-                    const auto &l = j.second;
-                    r.add(MergedInterval(gID + "-" + toString(l.start) + "-" + toString(l.end), l, gID, gID));
+                    r.add(MergedInterval(gID + "-" + std::to_string(l.start) + "-" + std::to_string(l.end), l, gID, gID));
                 }
             }
 
@@ -327,17 +371,10 @@ namespace Anaquin
         inline MergedIntervals<> ueInters(const ChrID &cID) const
         {
             MergedIntervals<> r;
-            
-            for (const auto &i : at(cID).t2ue)
+
+            for (const auto &i : ues.rows(cIDs.at(cID)))
             {
-                const auto &tID = i.first;
-                const auto &gID = at(cID).t2g.at(tID);
-                
-                for (const auto &j : i.second)
-                {
-                    r.add(MergedInterval(i.first + "-" + toString(j.l.start) + "-" + toString(j.l.end),
-                                         j.l, gID, tID));
-                }
+                r.add(MergedInterval(name(tIDs[i.t], i), i.l(), gIDs[i.g], tIDs[i.t]));
             }
 
             r.build();
@@ -348,12 +385,12 @@ namespace Anaquin
         inline Chr2MInters ueInters() const
         {
             Chr2MInters r;
-            
-            for (const auto &i : *this)
+
+            for (NameID i = 0; i < cIDs.size(); i++)
             {
-                r[i.first] = ueInters(i.first);
+                r[cIDs[i]] = ueInters(cIDs[i]);
             }
-            
+
             return r;
         }
 
@@ -361,29 +398,20 @@ namespace Anaquin
          * Returns non-overlapping intervals for a chromosome. Each interval represents a set of merged
          * overlapping unique exons.
          */
-        
+
         inline MergedIntervals<> mergedExons(const ChrID &cID) const
         {
             MergedIntervals<> r;
-            
-            for (const auto &i : at(cID).t2ue)
-            {
-                const auto &tID = i.first;
-                const auto &gID = at(cID).t2g.at(tID);
 
-                for (auto &j : i.second)
-                {
-                    r.merge(MergedInterval(i.first + "-" + toString(j.l.start) + "-" + toString(j.l.end),
-                                           j.l,
-                                           gID,
-                                           tID));
-                }
+            for (const auto &i : ues.rows(cIDs.at(cID)))
+            {
+                r.merge(MergedInterval(name(tIDs[i.t], i), i.l(), gIDs[i.g], tIDs[i.t]));
             }
 
             r.build();
             return r;
         }
-        
+
         /*
          * Returns non-overlapping exon intervals for all chromosomes.
          */
@@ -391,30 +419,23 @@ namespace Anaquin
         inline Chr2MInters mergedExons() const
         {
             Chr2MInters r;
-            
-            for (const auto &i : *this)
+
+            for (NameID i = 0; i < cIDs.size(); i++)
             {
-                r[i.first] = mergedExons(i.first);
+                r[cIDs[i]] = mergedExons(cIDs[i]);
             }
-            
+
             return r;
         }
-        
+
         // Intervals for unique introns
         inline MergedIntervals<> uiInters(const ChrID &cID) const
         {
             MergedIntervals<> r;
-            
-            for (const auto &i : at(cID).t2ui)
-            {
-                const auto &tID = i.first;
-                const auto &gID = at(cID).t2g.at(tID);
 
-                for (const auto &j : i.second)
-                {
-                    r.add(MergedInterval(i.first + "-" + toString(j.l.start) + "-" + toString(j.l.end),
-                                         j.l, gID, tID));
-                }
+            for (const auto &i : uis.rows(cIDs.at(cID)))
+            {
+                r.add(MergedInterval(name(tIDs[i.t], i), i.l(), gIDs[i.g], tIDs[i.t]));
             }
 
             // Eg: chrM doesn't have any intron...
@@ -422,113 +443,166 @@ namespace Anaquin
             {
                 r.build();
             }
-            
+
             return r;
         }
-        
-        // Intervals for unique introns
-        inline Chr2MInters uiInters() const
+
+        // Intervals for unique introns (built once)
+        inline const Chr2MInters &uiInters() const
         {
-            Chr2MInters r;
-            
-            for (const auto &i : *this)
+            return _memo.get(_memo.c2m, std::make_pair(RNAFeature::Intron, Strand::Either), [&]() -> Chr2MInters
             {
-                r[i.first] = uiInters(i.first);
-            }
-            
-            return r;
+                Chr2MInters r;
+
+                for (NameID i = 0; i < cIDs.size(); i++)
+                {
+                    r[cIDs[i]] = uiInters(cIDs[i]);
+                }
+
+                return r;
+            });
         }
-        
+
         // Returns total length of all genes for a chromosome
         inline Base countLen(const ChrID &cID) const
         {
             // Assuming the genes are non-overlapping
             return gIntervals(cID).stats().length;
         }
-        
+
         inline Base countLenSyn() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
-            {
-                return isChrIS(cID) ? countLen(cID) : 0;
-            });
+            return countSyn([&](const ChrID &cID) { return countLen(cID); });
         }
-        
+
         inline Base countLenGen() const
         {
-            return countMap(*this, [&](const ChrID &cID, const ChrData &x)
+            Base n = 0;
+
+            for (NameID i = 0; i < cIDs.size(); i++)
             {
-                return !isChrIS(cID) ? countLen(cID) : 0;
-            });
+                n += !isChrIS(cIDs[i]) ? countLen(cIDs[i]) : 0;
+            }
+
+            return n;
         }
+
+        // Eg: chr1, ENSG00000223972.5 and ENST00000456328.2
+        Names cIDs, gIDs, tIDs;
+
+        // Genes (sorted by the gene names)
+        Features gs;
+
+        // Transcripts (sorted by the transcript names)
+        Features ts;
+
+        // Unique exons (sorted by the transcript names and then the positions)
+        Features ues;
+
+        // Unique introns (sorted by the transcript names and then the positions)
+        Features uis;
+
+        // Number of genes with transcripts for each chromosome
+        std::vector<Counts> c2g;
+
+        private:
+
+            mutable IntersMemo _memo;
+
+            // Eg: ENST00000456328.2-11869-12227
+            static inline std::string name(const std::string &x, const Feature &i)
+            {
+                return x + "-" + std::to_string(i.start) + "-" + std::to_string(i.end);
+            }
+
+            template <typename F> auto countSyn(F f) const -> decltype(f(ChrID()))
+            {
+                decltype(f(ChrID())) n = 0;
+
+                for (NameID i = 0; i < cIDs.size(); i++)
+                {
+                    n += isChrIS(cIDs[i]) ? f(cIDs[i]) : 0;
+                }
+
+                return n;
+            }
     };
 
+    /*
+     * Key for unique exons and introns. Chromosomes are given by the order they're first seen in the
+     * annotation, the strand is always Either for introns.
+     */
+
+    struct UniqueKey
+    {
+        inline bool operator==(const UniqueKey &x) const
+        {
+            return c == x.c && str == x.str && start == x.start && end == x.end;
+        }
+
+        std::size_t c;
+        Strand str;
+        Base start, end;
+    };
+
+    struct UniqueHash
+    {
+        inline std::size_t operator()(const UniqueKey &x) const
+        {
+            return mix64(mix64((x.c << 2 | x.str) ^ mix64(x.start)) ^ x.end);
+        }
+    };
+
+    typedef std::unordered_set<UniqueKey, UniqueHash> UniqueSet;
+
     inline GTFData gtfData(const Reader &r)
     {
-        GTFData c2d;
-        
+        GTFData x;
+
         // Used for unique exons
-        std::map<std::string, Locus> m_exons;
-        
+        UniqueSet m_exons;
+
         // Used for unique introns
-        std::map<std::string, Locus> m_intrs;
+        UniqueSet m_intrs;
+
+        // Rows in the order they're seen
+        std::vector<Feature> gs, ts, ues, uis, exons;
 
-        ExonData ed;
-        GeneData gd;
-        TransData td;
-        IntronData id;
-        
-        ParserGTF::parse(r, [&](const ParserGTF::Data &x, const std::string &, const ParserProgress &)
+        // Genes referred by the transcripts
+        std::vector<std::pair<NameID, NameID>> c2g;
+
+        ParserGTF::parse(r, [&](const ParserGTF::Data &i, const LineView &, const ParserProgress &)
         {
-            switch (x.type)
+            switch (i.type)
             {
                 case RNAFeature::Transcript:
                 {
-                    td.l   = x.l;
-                    td.cID = x.cID;
-                    td.gID = x.gID;
-                    td.tID = x.tID;
-
-                    c2d[x.cID].gIDs.insert(td.gID);
-                    c2d[x.cID].t2g[td.tID] = td.gID;
-                    c2d[x.cID].t2d[td.tID] = td;
+                    const auto c = x.cIDs.add(i.cID);
+                    const auto g = x.gIDs.add(i.gID);
+
+                    ts.push_back(Feature { c, g, x.tIDs.add(i.tID), i.str, i.l.start, i.l.end });
+                    c2g.push_back(std::make_pair(c, g));
                     break;
                 }
 
                 case RNAFeature::Gene:
                 {
-                    gd.l   = x.l;
-                    gd.cID = x.cID;
-                    gd.gID = x.gID;
-                    
-                    c2d[x.cID].g2d[gd.gID] = gd;
+                    gs.push_back(Feature { x.cIDs.add(i.cID), x.gIDs.add(i.gID), 0, i.str, i.l.start, i.l.end });
                     break;
                 }
 
                 case RNAFeature::Exon:
                 {
-                    ed.l   = x.l;
-                    ed.str = x.str;
-                    ed.cID = x.cID;
-                    ed.gID = x.gID;
-                    ed.tID = x.tID;
+                    const auto c = x.cIDs.add(i.cID);
 
-                    c2d[x.cID].t2e[ed.tID].insert(ed);
-
-                    // The key represents a unique exon
-                    const auto key = (boost::format("%1%_%2%_%3%-%4%") % x.cID
-                                                                       % x.str
-                                                                       % x.l.start
-                                                                       % x.l.end).str();
+                    exons.push_back(Feature { c, x.gIDs.add(i.gID), x.tIDs.add(i.tID), i.str, i.l.start, i.l.end });
 
                     // Make sure it's unique due to alternative splicing
-                    if (!m_exons.count(key))
+                    if (m_exons.insert(UniqueKey { c, i.str, i.l.start, i.l.end }).second)
                     {
-                        m_exons[key] = x.l;
-                        c2d[x.cID].uexons++;
-                        c2d[x.cID].t2ue[ed.tID].insert(ed);
+                        ues.push_back(exons.back());
                     }
-                    
+
                     break;
                 }
 
@@ -536,83 +610,126 @@ namespace Anaquin
                 default: { break; }
             }
         });
-        
+
+        const auto g2r = x.gIDs.ranks();
+        const auto t2r = x.tIDs.ranks();
+
+        auto byGene = [&](const Feature &i, const Feature &j)
+        {
+            return i.c < j.c || (i.c == j.c && g2r[i.g] < g2r[j.g]);
+        };
+
+        auto byTrans = [&](const Feature &i, const Feature &j)
+        {
+            return i.c < j.c || (i.c == j.c && (t2r[i.t] < t2r[j.t] || (i.t == j.t && i < j)));
+        };
+
+        // The last definition is taken for duplicated genes and transcripts
+        auto last = [&](std::vector<Feature> &x, bool isGene)
+        {
+            std::vector<Feature> r;
+
+            for (auto i = x.rbegin(); i != x.rend(); i++)
+            {
+                if (r.empty() || r.back().c != i->c || (isGene ? r.back().g != i->g : r.back().t != i->t))
+                {
+                    r.push_back(*i);
+                }
+            }
+
+            std::reverse(r.begin(), r.end());
+            x.swap(r);
+        };
+
+        std::stable_sort(gs.begin(), gs.end(), byGene);
+        std::stable_sort(ts.begin(), ts.end(), [&](const Feature &i, const Feature &j)
+        {
+            return i.c < j.c || (i.c == j.c && t2r[i.t] < t2r[j.t]);
+        });
+
+        last(gs, true);
+        last(ts, false);
+
+        std::stable_sort(ues.begin(), ues.end(), byTrans);
+        std::stable_sort(exons.begin(), exons.end(), byTrans);
+
+        // The first exon is taken for duplicated exons in a transcript
+        exons.erase(std::unique(exons.begin(), exons.end(), [&](const Feature &i, const Feature &j)
+        {
+            return i.c == j.c && i.t == j.t && i.start == j.start && i.end == j.end;
+        }), exons.end());
+
+        std::sort(c2g.begin(), c2g.end());
+        c2g.erase(std::unique(c2g.begin(), c2g.end()), c2g.end());
+
+        x.c2g.resize(x.cIDs.size());
+
+        for (const auto &i : c2g)
+        {
+            x.c2g[i.first]++;
+        }
+
         /*
          * The information we have is sufficient for exons, transcripts and genes. We just
          * need to compute introns.
          */
-        
-        // For each chromosome...
-        for (auto &i : c2d)
+
+        // For each transcript (the exons are sorted)...
+        for (std::size_t i = 0, j; i < exons.size(); i = j)
         {
-            // For each transcript...
-            for (const auto &j : i.second.t2e)
+            for (j = i + 1; j < exons.size() && exons[j].c == exons[i].c && exons[j].t == exons[i].t; j++);
+
+            /*
+             * -------------------------------------- Cufflinks Bug --------------------------------------
+             *
+             * It's possible for Cufflink guided assembly to give a transcript in both forward and backward
+             * strand. An example is in "cufflink_bug.png" in the source distribution. Clearly invalid,
+             * and thus we'll ignore the transcript.
+             */
+
+            bool shouldSkip = false;
+
+            for (auto k = i + 1; k < j && !shouldSkip; k++)
             {
-                // Sorted exons
-                auto sorted = std::vector<ExonData>();
-                
-                // Sort the exons
-                std::copy(j.second.begin(), j.second.end(), std::back_inserter(sorted));
-                
-                /*
-                 * -------------------------------------- Cufflinks Bug --------------------------------------
-                 *
-                 * It's possible for Cufflink guided assembly to give a transcript in both forward and backward
-                 * strand. An example is in "cufflink_bug.png" in the source distribution. Clearly invalid,
-                 * and thus we'll ignore the transcript.
-                 */
-                
-                bool shouldSkip = false;
-
-                for (auto k = 1; k < sorted.size() && !shouldSkip; k++)
+                if (exons[k-1].str != exons[k].str)
                 {
-                    const auto &x = sorted[k-1];
-                    const auto &y = sorted[k];
-
-                    if (x.str != y.str)
-                    {
-                        printWarning(j.first + " gives transcription in both forward and backward strand. Ignored.");
-                        shouldSkip = true;
-                    }
+                    printWarning(x.tIDs[exons[i].t] + " gives transcription in both forward and backward strand. Ignored.");
+                    shouldSkip = true;
                 }
+            }
 
-                /*
-                 * Generating introns, only possible once the exons are sorted.
-                 */
-                
-                for (auto j = 1; j < sorted.size() && !shouldSkip; j++)
+            /*
+             * Generating introns, only possible once the exons are sorted.
+             */
+
+            for (auto k = i + 1; k < j && !shouldSkip; k++)
+            {
+                auto id = exons[k-1];
+
+                // Intron spans between exons
+                const auto l = Locus(exons[k-1].end+1, exons[k].start-1);
+
+                id.start = l.start;
+                id.end   = l.end;
+
+                #define MIN_INTRON_LEN 4
+
+                if (isChrIS(x.cIDs[id.c]) || l.length() >= MIN_INTRON_LEN)
                 {
-                    const auto &x = sorted[j-1];
-                    const auto &y = sorted[j];
-
-                    id.cID = x.cID;
-                    id.gID = x.gID;
-                    id.tID = x.tID;
-                    id.str = x.str;
-
-                    // Intron spans between exons
-                    id.l = Locus(x.l.end+1, y.l.start-1);
-
-                    #define MIN_INTRON_LEN 4
-                    
-                    const auto key = (boost::format("%1%_%2%-%3%") % x.cID
-                                                                   % id.l.start
-                                                                   % id.l.end).str();
-                    
-                    if (isChrIS(i.first) || id.l.length() >= MIN_INTRON_LEN)
+                    if (m_intrs.insert(UniqueKey { id.c, Strand::Either, id.start, id.end }).second)
                     {
-                        if (!m_intrs.count(key))
-                        {
-                            c2d[x.cID].uintrs++;
-                            m_intrs[key] = id.l;
-                            c2d[x.cID].t2ui[id.tID].insert(id);
-                        }
+                        uis.push_back(id);
                     }
                 }
             }
         }
 
-        return c2d;
+        x.gs  = Features(std::move(gs),  x.cIDs.size());
+        x.ts  = Features(std::move(ts),  x.cIDs.size());
+        x.ues = Features(std::move(ues), x.cIDs.size());
+        x.uis = Features(std::move(uis), x.cIDs.size());
+
+        return x;
     }
 }
 
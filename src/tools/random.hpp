@@ -2,33 +2,76 @@
 #define RANDOM_HPP
 
 #include <string>
-#include <klib/khash.h>
+#include <cstring>
+#include <cstdint>
 #include "tools/errors.hpp"
 
 namespace Anaquin
 {
+    typedef uint64_t Seed;
+
+    // Finalizer of SplitMix64, every bit of the input affects every bit of the output
+    inline uint64_t mix64(uint64_t x)
+    {
+        x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // 64-bit hash of a string, eight bytes at a time
+    inline uint64_t hash64(const char *s, std::size_t n, Seed seed)
+    {
+        auto h = mix64(seed ^ (n * 0x9e3779b97f4a7c15ULL));
+
+        for (; n >= 8; s += 8, n -= 8)
+        {
+            uint64_t k;
+            memcpy(&k, s, 8);
+            h = mix64(h ^ k);
+        }
+
+        if (n)
+        {
+            uint64_t k = 0;
+            memcpy(&k, s, n);
+            h = mix64(h ^ k);
+        }
+
+        return h;
+    }
+
+    /*
+     * Selection by the hash of a key (eg: read name), thus the decision depends only on the key and the seed. Mates
+     * have the same name and are always selected together. The results are reproducible regardless of the order.
+     */
+
     class RandomSelection
     {
         public:
 
-            RandomSelection(double prob, int seed = rand())  : _prob(prob), _seed(seed)
+            RandomSelection(double prob, Seed seed = 0) : _prob(prob), _seed(seed)
             {
                 A_ASSERT(prob >= 0.0);
             }
 
-            inline bool select(const std::string &hash) const
+            inline bool select(const char *key) const
             {
-                const uint32_t k = __ac_Wang_hash(__ac_X31_hash_string(hash.c_str()) ^ _seed);
-                return ((double)(k&0xffffff) / 0x1000000 >= _prob);
+                // Top 53 bits for a uniform number in [0, 1)
+                return (hash64(key, strlen(key), _seed) >> 11) / 9007199254740992.0 >= _prob;
             }
 
-        private:
+            inline bool select(const std::string &key) const
+            {
+                return (hash64(key.data(), key.size(), _seed) >> 11) / 9007199254740992.0 >= _prob;
+            }
 
-            // Random seed
-            int _seed;
+        private:
 
-            // The probability of selection
+            // The probability of not being selected
             const double _prob;
+
+            // Random seed
+            const Seed _seed;
     };
 }
 
@@ -1,31 +1,64 @@
 #include "tools/sample.hpp"
 #include "parsers/parser_bam.hpp"
 #include "writers/sam_writer.hpp"
+#include "writers/bam_writer.hpp"
 
 using namespace Anaquin;
 
-Sampler::Stats Sampler::sample(const FileName &file, Proportion p, const AnalyzerOptions &o, std::function<bool (const ChrID &)> isSyn)
+Sampler::Stats Sampler::sample(const FileName &file, Proportion p, const AnalyzerOptions &o, std::function<bool (const ChrID &)> isSyn, const FileName &out, Seed seed)
 {
     Sampler::Stats stats;
 
     A_ASSERT(p > 0.0 && p <= 1.0);
-    Random r(1.0 - p);
+    Random r(1.0 - p, seed);
 
-    SAMWriter w;
-    w.open("");
-    
-    ParserBAM::parse(file, [&](ParserBAM::Data &x, const ParserBAM::Info &info)
+    SAMWriter s;
+    BAMWriter b;
+
+    if (out.empty())
+    {
+        s.open("");
+    }
+    else
+    {
+        b.open(out, file, o.thr);
+    }
+
+    // Decision for an alignment by the workers
+    enum Decision
+    {
+        Syn   = 1,
+        Write = 2,
+    };
+
+    /*
+     * Records are partitioned across the workers, which decide in parallel. Each decision depends only
+     * on the read name and the seed, and records are written in the file order, thus the output is
+     * identical for any number of threads.
+     */
+
+    ParserBAM::parse(file, [&](ParserBAM::Data &x, const ParserBAM::Info &) -> int
+    {
+        // Unmapped mates placed on the in-silico chromosome are sampled together with the mates
+        if (x.tid() < 0 || !isSyn(x.cID))
+        {
+            return Write;
+        }
+
+        // This is the key, randomly write the reads with certain probability
+        return Syn | (r.select(bam_get_qname(static_cast<bam1_t *>(x.b()))) ? Write : 0);
+    }, [&](ParserBAM::Data &x, const ParserBAM::Info &info, int d)
     {
         if (info.p.i && !(info.p.i % 1000000))
         {
             o.logInfo(std::to_string(info.p.i));
         }
-        
-        const auto shouldWrite = !x.mapped || !isSyn(x.cID) || !x.isAligned;
 
+        const auto syn = d & Syn;
+        
         if (x.isPrimary && x.isAligned)
         {
-            if (isSyn(x.cID))
+            if (syn)
             {
                 stats.before.syn++;
             }
@@ -35,13 +68,14 @@ Sampler::Stats Sampler::sample(const FileName &file, Proportion p, const Analyze
             }
         }
 
-        // This is the key, randomly write the reads with certain probability
-        if (shouldWrite || r.select(x.name))
+        if (d & Write)
         {
-            if (x.isPrimary && x.isAligned && isSyn(x.cID))
+            const auto name = bam_get_qname(static_cast<bam1_t *>(x.b()));
+
+            if (x.isPrimary && x.isAligned && syn)
             {
                 stats.after.syn++;
-                o.logInfo("Sampled " + x.name);
+                o.logInfo("Sampled " + std::string(name));
             }
 
             /*
@@ -49,18 +83,32 @@ Sampler::Stats Sampler::sample(const FileName &file, Proportion p, const Analyze
              * give '*' to QNAME, but not an empty string....
              */
             
-            if (!x.name.empty())
+            if (*name)
             {
-                // Print SAM line
-                w.write(x);
+                if (out.empty())
+                {
+                    // Print SAM line
+                    s.write(x);
+                }
+                else
+                {
+                    b.write(x);
+                }
             }
         }
-    }, true);
+    }, false, o.thr);
     
     A_ASSERT(stats.before.syn >= stats.after.syn);
     stats.after.gen = stats.before.gen;
     
-    w.close();
+    if (out.empty())
+    {
+        s.close();
+    }
+    else
+    {
+        b.close();
+    }
     
     return stats;
 }
@@ -2,7 +2,7 @@
 #define SAMPLE_HPP
 
 #include <functional>
-#include <klib/khash.h>
+#include "tools/random.hpp"
 #include "stats/analyzer.hpp"
 
 namespace Anaquin
@@ -26,36 +26,26 @@ namespace Anaquin
             SGReads before, after;
         };
         
+        /*
+         * Sampled alignments are written to the output file (BAM, CRAM or SAM by the extension),
+         * or printed to the console as SAM if no output is given. Alignments are written in the
+         * same order as the input. The function for the in-silico chromosome is called concurrently.
+         */
+
         static Stats sample(const FileName &,
                             Proportion,
                             const AnalyzerOptions &,
-                            std::function<bool (const ChrID &)>);
+                            std::function<bool (const ChrID &)>,
+                            const FileName &out = "",
+                            Seed seed = 0);
     };
     
-    class Random
-    {
-        public:
-        
-            Random(double prob) : _prob(prob)
-            {
-                assert(prob >= 0.0);
-                _seed = rand();
-            }
-        
-            inline bool select(const std::string &hash) const
-            {
-                const uint32_t k = __ac_Wang_hash(__ac_X31_hash_string(hash.c_str()) ^ _seed);
-                return ((double)(k&0xffffff) / 0x1000000 >= _prob);
-            }
-        
-        private:
-        
-            // Random seed
-            int _seed;
+    /*
+     * Read names are hashed with the seed, the decision is the same for both mates, the same
+     * for each run and doesn't depend on the number of threads.
+     */
 
-            // The probability of selection
-            Probability _prob;
-    };
+    typedef RandomSelection Random;
 }
 
 #endif
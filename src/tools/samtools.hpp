@@ -12,19 +12,6 @@ namespace Anaquin
 {
     typedef std::string CigarStr;
     
-    static std::map<int, char> bam2char =
-    {
-        { BAM_CMATCH,     'M'  },
-        { BAM_CINS,       'I'  },
-        { BAM_CDEL,       'D'  },
-        { BAM_CREF_SKIP,  'N'  },
-        { BAM_CSOFT_CLIP, 'S', },
-        { BAM_CHARD_CLIP, 'H', },
-        { BAM_CPAD,       'P', },
-        { BAM_CEQUAL,     '=', },
-        { BAM_CDIFF,      'X', },
-    };
-
     inline std::string bam2rnext(bam_hdr_t *h, bam1_t *b)
     {
         const auto cID = std::string(h->target_name[b->core.tid]);
@@ -45,42 +32,106 @@ namespace Anaquin
         return rID;
     }
     
-    inline std::string bam2qual(bam1_t *x)
+    /*
+     * Decoders writing into a buffer given by the caller. The buffer can be reused for every
+     * alignment, thus no memory is allocated once it's large enough.
+     */
+
+    // ASCII of base quality, the loop is simple enough for the compiler to vectorize
+    inline void bam2qual(bam1_t *x, std::string &r)
     {
-        std::stringstream buf;
-        
-        for (auto i = 0; i < x->core.l_qseq; ++i)
+        const auto n = x->core.l_qseq;
+        const auto q = bam_get_qual(x);
+
+        r.resize(n);
+
+        for (auto i = 0; i < n; i++)
         {
-            buf << (char) (bam_get_qual(x)[i] + 33);
+            r[i] = static_cast<char>(q[i] + 33);
         }
-        
-        return buf.str();
     }
-    
-    inline std::string bam2seq(bam1_t *x)
+
+    inline std::string bam2qual(bam1_t *x)
     {
-        std::stringstream buf;
+        std::string r;
+        bam2qual(x, r);
+        return r;
+    }
 
-        for (auto i = 0; i < x->core.l_qseq; ++i)
+    // Two bases for every byte of the 4-bit encoded sequence
+    inline const char (&nt16Pairs())[256][2]
+    {
+        static char t[256][2];
+        static bool init = [&]()
         {
-            buf << seq_nt16_str[bam_seqi(bam_get_seq(x),i)];
+            for (auto i = 0; i < 256; i++)
+            {
+                t[i][0] = seq_nt16_str[i >> 4];
+                t[i][1] = seq_nt16_str[i & 0xf];
+            }
+
+            return true;
+        }();
+
+        (void) init;
+        return t;
+    }
+
+    inline void bam2seq(bam1_t *x, std::string &r)
+    {
+        const auto &t = nt16Pairs();
+        const auto n = x->core.l_qseq;
+        const auto s = bam_get_seq(x);
+
+        r.resize(n);
+
+        for (auto i = 0; i < n / 2; i++)
+        {
+            r[2*i]   = t[s[i]][0];
+            r[2*i+1] = t[s[i]][1];
         }
 
-        return buf.str();
+        // The last base for an odd length
+        if (n & 1)
+        {
+            r[n-1] = t[s[n/2]][0];
+        }
     }
-    
-    inline CigarStr bam2cigar(bam1_t *x)
+
+    inline std::string bam2seq(bam1_t *x)
+    {
+        std::string r;
+        bam2seq(x, r);
+        return r;
+    }
+
+    inline void bam2cigar(bam1_t *x, CigarStr &r)
     {
-        std::stringstream buf;
         const auto t = bam_get_cigar(x);
 
+        r.clear();
+
         for (auto i = 0; i < x->core.n_cigar; i++)
         {
-            buf << std::to_string(bam_cigar_oplen(t[i]));
-            buf << bam2char.at(bam_cigar_op(t[i]));
+            // Enough for 32-bit lengths, written backward
+            char buf[16];
+            auto p = buf + sizeof(buf);
+
+            for (auto l = bam_cigar_oplen(t[i]); p == buf + sizeof(buf) || l; l /= 10)
+            {
+                *--p = '0' + l % 10;
+            }
+
+            r.append(p, buf + sizeof(buf));
+            r.push_back(bam_cigar_opchr(t[i]));
         }
-        
-        return buf.str();
+    }
+
+    inline CigarStr bam2cigar(bam1_t *x)
+    {
+        CigarStr r;
+        bam2cigar(x, r);
+        return r;
     }
 }
 
@@ -1,13 +1,80 @@
+#include <boost/algorithm/string/predicate.hpp>
 #include "writers/bam_writer.hpp"
 
 using namespace Anaquin;
 
+BAMWriter::~BAMWriter()
+{
+    // Errors can't be thrown from here, close() should have been called
+    if (_fp)
+    {
+        sam_close(_fp);
+    }
+}
+
 void BAMWriter::close()
 {
-    sam_close(_fp);
+    if (_fp)
+    {
+        const auto r = sam_close(_fp);
+        _fp = nullptr;
+
+        // Buffered records are flushed when closing
+        if (r < 0)
+        {
+            throw std::runtime_error("Failed to close " + _file);
+        }
+    }
 }
-        
-void BAMWriter::open(const FileName &file)
+
+void BAMWriter::open(const FileName &file, const FileName &src, unsigned thr)
 {
-    _fp = sam_open(file.c_str(), "wb");
+    const auto cram = boost::iends_with(file, ".cram");
+
+    // Format by extension, BAM for anything else
+    const auto mode = cram ? "wc" : boost::iends_with(file, ".sam") ? "w" : "wb";
+
+    auto f = sam_open(src.c_str(), "r");
+    
+    if (!f)
+    {
+        throw std::runtime_error("Failed to open " + src);
+    }
+    
+    auto h = sam_hdr_read(f);
+    sam_close(f);
+
+    if (!h)
+    {
+        throw std::runtime_error("Failed to read the header of " + src);
+    }
+
+    _file = file;
+
+    if (!(_fp = sam_open(file.c_str(), mode)))
+    {
+        bam_hdr_destroy(h);
+        throw std::runtime_error("Failed to open " + file + " for writing");
+    }
+
+    // No reference is given, htslib would otherwise look it up by the MD5 for encoding
+    if (cram && hts_set_opt(_fp, CRAM_OPT_NO_REF, 1))
+    {
+        bam_hdr_destroy(h);
+        throw std::runtime_error("Failed to write CRAM without reference for " + file);
+    }
+
+    // Compressing by the thread pool, one thread is reserved for writing
+    if (thr > 1)
+    {
+        hts_set_threads(_fp, thr - 1);
+    }
+
+    const auto r = sam_hdr_write(_fp, h);
+    bam_hdr_destroy(h);
+
+    if (r == -1)
+    {
+        throw std::runtime_error("sam_hdr_write failed");
+    }
 }
@@ -10,21 +10,23 @@ namespace Anaquin
     {
         public:
 
+            ~BAMWriter();
+
             void close();
-            void open(const FileName &);
+
+            /*
+             * BAM, CRAM or SAM by the extension, extra threads for compression. The header is copied
+             * from the source alignment file and written immediately, thus an empty output is still
+             * valid. CRAM is written without a reference, the bases are stored verbatim.
+             */
+
+            void open(const FileName &, const FileName &src, unsigned thr = 1);
 
             template <typename T> void write(const T &x)
             {
                 const auto *b = reinterpret_cast<bam1_t *>(x.b());
                 const auto *h = reinterpret_cast<bam_hdr_t *>(x.h());
                 
-                if (!_head && sam_hdr_write(_fp, reinterpret_cast<bam_hdr_t *>(x.h())) == -1)
-                {
-                    throw std::runtime_error("sam_hdr_write failed");
-                }
-                
-                _head = true;
-                
                 if (sam_write1(_fp, h, b) == -1)
                 {
                     throw std::runtime_error("sam_write1 failed");
@@ -32,8 +34,8 @@ namespace Anaquin
             }
 
         private:
-            bool _head;        
-            samFile *_fp;
+            FileName _file;
+            samFile *_fp = nullptr;
     };
 }
 
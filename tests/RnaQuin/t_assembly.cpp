@@ -1,14 +1,95 @@
+#include <thread>
 #include <catch.hpp>
 #include "test.hpp"
 #include "RnaQuin/r_assembly.hpp"
+#include "cufflinks/cuffcompare.h"
 
 using namespace Anaquin;
 
-#ifdef LONG_TESTS
-
 // Defined in main.cpp
 extern void SetGTFRef(const FileName &);
 
+static Compare cuffcompare(const FileName &ref, const FileName &qry)
+{
+    CuffData r, q;
+    cuffReadRef(r, ref.c_str());
+    cuffReadQry(q, qry.c_str(), r);
+    return CuffCompare().compare(r, q);
+}
+
+TEST_CASE("Cuffcompare_Itself")
+{
+    const auto x = cuffcompare("tests/data/A1.gtf", "tests/data/A3.gtf");
+
+    REQUIRE(x.b_sn == 100.0);
+    REQUIRE(x.b_sp == 100.0);
+    REQUIRE(x.c_sn == 100.0);
+    REQUIRE(x.c_sp == 100.0);
+    REQUIRE(x.t_bsn.size() == 164);
+    REQUIRE(x.t_bsn.at("R1_101_1") == 100.0);
+}
+
+TEST_CASE("Cuffcompare_Concurrent")
+{
+    const std::vector<FileName> files = { "tests/data/A1.gtf", "tests/data/A2.gtf", "tests/data/A3.gtf", "tests/data/guided.gtf" };
+
+    std::vector<Compare> x, y(files.size());
+
+    for (const auto &i : files)
+    {
+        x.push_back(cuffcompare("tests/data/A1.gtf", i));
+    }
+
+    std::vector<std::thread> ts;
+
+    for (auto i = 0u; i < files.size(); i++)
+    {
+        ts.push_back(std::thread([&, i]()
+        {
+            y[i] = cuffcompare("tests/data/A1.gtf", files[i]);
+        }));
+    }
+
+    for (auto &t : ts)
+    {
+        t.join();
+    }
+
+    for (auto i = 0u; i < files.size(); i++)
+    {
+        REQUIRE(x[i].b_sn  == y[i].b_sn);
+        REQUIRE(x[i].b_sp  == y[i].b_sp);
+        REQUIRE(x[i].e_sn  == y[i].e_sn);
+        REQUIRE(x[i].i_sn  == y[i].i_sn);
+        REQUIRE(x[i].t_sn  == y[i].t_sn);
+        REQUIRE(x[i].t_sp  == y[i].t_sp);
+        REQUIRE(x[i].t_bsn == y[i].t_bsn);
+    }
+}
+
+TEST_CASE("Cuffcompare_Invalid")
+{
+    CuffData r;
+    REQUIRE_THROWS(cuffReadRef(r, "tests/data/missing.gtf"));
+}
+
+TEST_CASE("RAssembly_Invalid")
+{
+    clrTest();
+
+    UserReference r;
+    r.l1 = std::shared_ptr<Ladder>(new Ladder());
+    r.l1->add("R2_73_1", Mix_1, 1);
+    Standard::instance().r_rna.finalize(Tool::RnaAssembly, r);
+
+    // Invalid FPKM, the workers must be joined before the error is thrown
+    SetGTFRef("tests/data/guided.gtf");
+    REQUIRE_THROWS(RAssembly::analyze("tests/data/guidedInvalid.gtf"));
+    SetGTFRef("");
+}
+
+#ifdef LONG_TESTS
+
 TEST_CASE("RAssembly_CompareWithItself")
 {
     Test::transA();
@@ -1,3 +1,137 @@
+#include <fstream>
+#include <catch.hpp>
+#include "test.hpp"
+#include "RnaQuin/r_express.hpp"
+
+using namespace Anaquin;
+
+// Messages written by the analysis
+struct LinesWriter : public Writer<>
+{
+    inline void close() override {}
+    inline void open(const FileName &) override {}
+    inline void write(const std::string &x) override { lines.push_back(x); }
+
+    std::vector<std::string> lines;
+};
+
+// Isoforms R1_1_1 to R1_<n>_1 and genes R1_1 to R1_<n>
+static void expressLadder(unsigned n)
+{
+    clrTest();
+
+    UserReference r;
+    r.l1 = std::shared_ptr<Ladder>(new Ladder());
+    r.l2 = std::shared_ptr<Ladder>(new Ladder());
+
+    for (auto i = 1u; i <= n; i++)
+    {
+        r.l1->add("R1_" + std::to_string(i) + "_1", Mix_1, i);
+        r.l2->add("R1_" + std::to_string(i), Mix_1, i);
+    }
+
+    Standard::instance().r_rna.finalize(Tool::RnaExpress, r);
+}
+
+// Replicate with the abundance k*i for the i-th sequin, every fifth is zero (warned in the log)
+static FileName replicate(const FileName &name, unsigned n, double k)
+{
+    const auto file = "/tmp/anaquin_express_" + name;
+
+    std::ofstream w(file);
+    w << "ChrID\tGeneID\tIsoformID\tAbund\n";
+
+    for (auto i = 1u; i <= n; i++)
+    {
+        w << "chrIS\tR1_" << i << "\tR1_" << i << "_1\t" << (i % 5 ? k * i : 0) << "\n";
+    }
+    
+    w << "chr1\tENSG1\tENST1\t10\n";
+    
+    return file;
+}
+
+static std::vector<RExpress::Stats> analyze(const std::vector<FileName> &files, unsigned thr, std::vector<std::string> &log)
+{
+    auto l = std::make_shared<LinesWriter>();
+    
+    RExpress::Options o;
+    o.thr    = thr;
+    o.format = RExpress::Format::Anaquin;
+    o.logger = l;
+    
+    const auto r = RExpress::analyze(files, o);
+    log = l->lines;
+    
+    return r;
+}
+
+TEST_CASE("RExpress_Replicates")
+{
+    expressLadder(50);
+    
+    std::vector<FileName> files;
+
+    for (auto i = 0; i < 6; i++)
+    {
+        files.push_back(replicate("R" + std::to_string(i) + ".tsv", 50, i + 1));
+    }
+    
+    std::vector<std::string> l1, l2;
+    
+    const auto x = analyze(files, 1, l1);
+    const auto y = analyze(files, 4, l2);
+    
+    // Messages are replayed in the order of the files
+    REQUIRE(!l1.empty());
+    REQUIRE(l1 == l2);
+    
+    REQUIRE(x.size() == files.size());
+    REQUIRE(y.size() == files.size());
+
+    // Statistics in the order of the files
+    for (std::size_t i = 0; i < files.size(); i++)
+    {
+        REQUIRE(x[i].nISeqs == 40);
+        REQUIRE(x[i].isos.size() == 40);
+        REQUIRE(x[i].nISeqs == y[i].nISeqs);
+        REQUIRE(x[i].nIEndo == y[i].nIEndo);
+        REQUIRE(x[i].isos.size() == y[i].isos.size());
+        
+        for (const auto &j : x[i].isos)
+        {
+            REQUIRE(j.second.y == Approx((i + 1) * j.second.x));
+            REQUIRE(y[i].isos.at(j.first).y == j.second.y);
+        }
+    }
+}
+
+TEST_CASE("RExpress_FirstError")
+{
+    expressLadder(50);
+
+    // Nothing on the in-silico chromosome
+    const auto none = replicate("None.tsv", 0, 1);
+
+    const std::vector<FileName> files = { replicate("R1.tsv", 50, 1), none, replicate("R2.tsv", 50, 2), "/tmp/anaquin_express_missing.tsv" };
+    
+    for (auto thr : { 1u, 4u })
+    {
+        std::vector<std::string> l;
+        
+        try
+        {
+            analyze(files, thr, l);
+            FAIL("Expected an error");
+        }
+        catch (const std::runtime_error &ex)
+        {
+            // The first failing file in the order of the files, regardless of what failed first
+            REQUIRE(std::string(ex.what()) == "Failed to find anything on the in-silico chromosome: " + none);
+        }
+    }
+}
+
 //#include <catch.hpp>
 //#include "test.hpp"
 //#include "RnaQuin/r_express.hpp"
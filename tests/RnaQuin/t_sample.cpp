@@ -23,6 +23,51 @@ TEST_CASE("RSample_OverSubsampled")
     REQUIRE(r.after.dilut() == Approx(0.0711561719));
 }
 
+TEST_CASE("RSample_Index")
+{
+    // 1607 and 1800 primary alignments, 1748 and 1927 alignments by the index
+    const auto file = "tests/data/indexed.bam";
+
+    RSample::Options o1, o2;
+
+    o1.p = o2.p = 0.3;
+    o1.out = "/tmp/anaquin_sampled_1.bam";
+    o2.out = "/tmp/anaquin_sampled_2.bam";
+    o2.index = true;
+
+    clrTest();
+    const auto r1 = RSample::stats(file, o1);
+
+    clrTest();
+    const auto r2 = RSample::stats(file, o2);
+
+    REQUIRE(!r1.byIndex);
+    REQUIRE(r1.normSyn == 1607);
+    REQUIRE(r1.normGen == 1800);
+    REQUIRE(r1.norm == Approx((1800 / 0.7 - 1800) / 1607));
+
+    REQUIRE(r2.byIndex);
+    REQUIRE(r2.normSyn == 1748);
+    REQUIRE(r2.normGen == 1927);
+    REQUIRE(r2.norm == Approx((1927 / 0.7 - 1927) / 1748));
+    
+    // Counts in the summary are from the sampling pass
+    for (const auto &r : { r1, r2 })
+    {
+        REQUIRE(r.before.syn == 1607);
+        REQUIRE(r.before.gen == 1800);
+        REQUIRE(r.after.gen  == 1800);
+    }
+
+    /*
+     * The index over-counts both sides by 7-9% (secondary and supplementary alignments), the norm is
+     * within 2%. The same seed selects a subset, within 10% of the full pass.
+     */
+
+    REQUIRE(r2.after.syn <= r1.after.syn);
+    REQUIRE(r2.after.syn >= 0.9 * r1.after.syn);
+}
+
 TEST_CASE("RSample_Negative")
 {
     clrTest();
@@ -0,0 +1,41 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <functional>
+
+/*
+ * Helpers for the hidden "[.benchmark]" test cases, run explicitly with "[.benchmark]" as the tag.
+ */
+
+namespace Anaquin
+{
+    // Runs f() and prints the time taken
+    template <typename F> void benchmark(const std::string &name, F f)
+    {
+        using namespace std::chrono;
+
+        const auto t = high_resolution_clock::now();
+        f();
+        const auto d = duration_cast<milliseconds>(high_resolution_clock::now() - t).count();
+
+        std::cout << std::left << std::setw(16) << name + ":" << d << " ms" << std::endl;
+    }
+
+    // Generates a fixture too large for tests/data, returns the file name
+    inline std::string benchmarkFile(const std::string &name, std::function<void (std::ostream &)> f)
+    {
+        const auto file = "/tmp/anaquin_" + name;
+
+        std::ofstream w(file);
+        f(w);
+
+        return file;
+    }
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <catch.hpp>
+#include "data/cache.hpp"
+
+using namespace Anaquin;
+
+TEST_CASE("Cache_GTF")
+{
+    setenv("ANAQUIN_CACHE", "/tmp/anaquin_cache", 1);
+
+    const auto r = Reader("tests/data/A1.gtf");
+    const auto file = Cache::path(r, "gtf");
+
+    remove(file.c_str());
+    REQUIRE(!file.empty());
+
+    // Built and saved
+    const auto x1 = Cache::get<GTFData>(r, "gtf", [&]() { return gtfData(r); });
+
+    // Loaded
+    const auto x2 = Cache::get<GTFData>(r, "gtf", [&]() -> GTFData { throw std::runtime_error("Not cached"); });
+
+    REQUIRE(x1.chrs()          == x2.chrs());
+    REQUIRE(x1.nGene()         == x2.nGene());
+    REQUIRE(x1.countTrans()    == x2.countTrans());
+    REQUIRE(x1.countUExon()    == x2.countUExon());
+    REQUIRE(x1.countUIntr()    == x2.countUIntr());
+    
+    for (const auto &i : x1.chrs())
+    {
+        REQUIRE(x1.genes(i) == x2.genes(i));
+        REQUIRE(x1.nGene(i) == x2.nGene(i));
+        REQUIRE(x1.countTrans(i) == x2.countTrans(i));
+        REQUIRE(x1.countUIntr(i) == x2.countUIntr(i));
+    }
+    
+    for (const auto &i : x1.ues.x)
+    {
+        const auto &j = x2.ues.x.at(&i - x1.ues.x.data());
+
+        REQUIRE(i.start == j.start);
+        REQUIRE(i.end   == j.end);
+        REQUIRE(i.str == j.str);
+        REQUIRE(x1.gIDs[i.g] == x2.gIDs[j.g]);
+        REQUIRE(x1.tIDs[i.t] == x2.tIDs[j.t]);
+    }
+
+    // Different content, different entry
+    REQUIRE(Cache::path(Reader("tests/data/A2.gtf"), "gtf") != file);
+
+    // Memory can't be cached
+    REQUIRE(Cache::path(Reader("chrIS\t1\t2", DataMode::String), "gtf").empty());
+    
+    unsetenv("ANAQUIN_CACHE");
+    REQUIRE(Cache::path(r, "gtf").empty());
+}
+
+TEST_CASE("Cache_Invalid")
+{
+    const auto file = "/tmp/anaquin_cache_invalid";
+    const auto x = gtfData(Reader("tests/data/A1.gtf"));
+
+    Cache::save(file, x);
+    
+    std::string b;
+    
+    {
+        std::ifstream r(file, std::ios::binary);
+        std::stringstream s;
+        s << r.rdbuf();
+        b = s.str();
+    }
+    
+    // The last transcript as it's written (field by field), genes have no transcript
+    const auto &t = x.ts.x.back();
+    
+    std::string row;
+    
+    const uint32_t c = t.c, g = t.g, tID = t.t;
+    const uint8_t str = t.str;
+
+    row.append(reinterpret_cast<const char *>(&c), 4);
+    row.append(reinterpret_cast<const char *>(&g), 4);
+    row.append(reinterpret_cast<const char *>(&tID), 4);
+    row.append(reinterpret_cast<const char *>(&str), 1);
+    row.append(reinterpret_cast<const char *>(&t.start), sizeof(Base));
+    row.append(reinterpret_cast<const char *>(&t.end), sizeof(Base));
+    
+    const auto i = b.find(row);
+    REQUIRE(i != std::string::npos);
+    
+    GTFData y;
+    REQUIRE(Cache::load(file, y));
+    
+    // Transcript out of the table
+    const uint32_t bad = x.tIDs.size();
+    b.replace(i + 8, 4, reinterpret_cast<const char *>(&bad), 4);
+    
+    std::ofstream(file, std::ios::binary) << b;
+    
+    GTFData z;
+    REQUIRE(!Cache::load(file, z));
+}
+
+TEST_CASE("Cache_Ladder")
+{
+    setenv("ANAQUIN_CACHE", "/tmp/anaquin_cache", 1);
+
+    const auto r = Reader("tests/data/A1.tsv");
+    remove(Cache::path(r, "test").c_str());
+
+    Ladder l;
+    l.add("R1_1", Mix_1, 1.5);
+    l.add("R1_1", Mix_2, 2.5);
+    l.add("R1_2", Mix_1, 3.5);
+
+    Cache::get<Ladder>(r, "test", [&]() { return l; });
+    const auto x = Cache::get<Ladder>(r, "test", [&]() { return Ladder(); });
+
+    REQUIRE(x.seqs == l.seqs);
+    REQUIRE(x.m1   == l.m1);
+    REQUIRE(x.m2   == l.m2);
+
+    unsetenv("ANAQUIN_CACHE");
+}
@@ -1,3 +1,4 @@
+#include <random>
 #include <catch.hpp>
 #include "data/dinters.hpp"
 
@@ -223,3 +224,91 @@ TEST_CASE("Interval_Test_4")
     REQUIRE(!i.overlap(Locus(400,  450)));
     REQUIRE(!i.overlap(Locus(1000, 1000)));
 }
+
+TEST_CASE("Interval_Test_7")
+{
+    DIntervals<> i;
+    
+    // The index visits the latest start first
+    i.add(DInter("A", Locus(40, 70)));
+    i.add(DInter("C", Locus(1, 100)));
+    i.add(DInter("B", Locus(1, 100)));
+    i.add(DInter("D", Locus(1, 200)));
+    i.build();
+
+    // The lowest start, then the lowest end, then the name
+    REQUIRE(i.firstContains(Locus(50, 60))->id() == "B");
+    REQUIRE(i.firstOverlap(Locus(60, 150))->id()  == "B");
+    REQUIRE(i.firstExact(Locus(1, 100))->id()     == "B");
+    REQUIRE(i.firstExact(Locus(40, 70))->id()     == "A");
+    REQUIRE(i.firstContains(Locus(150, 160))->id() == "D");
+
+    std::vector<DInter *> r;
+    
+    REQUIRE(i.contains(Locus(50, 60), &r)->id() == "B");
+    REQUIRE(r.size() == 4);
+    
+    r.clear();
+    REQUIRE(i.overlap(Locus(60, 150), &r)->id() == "B");
+    REQUIRE(r.size() == 4);
+
+    r.clear();
+    REQUIRE(i.exact(Locus(1, 100), &r)->id() == "B");
+    REQUIRE(r.size() == 2);
+}
+
+TEST_CASE("Interval_Test_6")
+{
+    std::mt19937 g(1);
+    
+    const auto n = 5000;
+    
+    DInter x("Test", Locus(1001, 1000 + n));
+    
+    // Depth for each base
+    std::vector<Coverage> d(n, 0);
+    
+    for (auto i = 0; i < 20000; i++)
+    {
+        const Base start = 900 + g() % (n + 200);
+        const auto l = Locus(start, start + g() % 150);
+        
+        x.map(l);
+        
+        for (auto j = std::max(l.start, 1001LL); j <= std::min(l.end, 1000LL + n); j++)
+        {
+            d[j - 1001]++;
+        }
+    }
+    
+    std::vector<Coverage> r;
+    
+    x.bedGraph([&](const ChrID &, Base i, Base j, Coverage cov)
+    {
+        REQUIRE(i < j);
+        
+        // Adjacent blocks must differ
+        REQUIRE((r.empty() || r.back() != cov));
+        
+        for (auto k = i; k < j; k++)
+        {
+            r.push_back(cov);
+        }
+    });
+    
+    REQUIRE(r == d);
+    
+    const auto s = x.stats();
+    
+    REQUIRE(s.nonZeros == std::count_if(d.begin(), d.end(), [&](Coverage i) { return i > 0; }));
+    
+    // Percentiles from the histogram must be the same as sorting every base
+    std::sort(d.begin(), d.end());
+    
+    REQUIRE(s.p25 == Approx(SS::quant(d, 0.25)));
+    REQUIRE(s.p50 == Approx(SS::quant(d, 0.50)));
+    REQUIRE(s.p75 == Approx(SS::quant(d, 0.75)));
+    
+    DInter::Stats e;
+    REQUIRE(std::isnan(e.quant(0.5)));
+}
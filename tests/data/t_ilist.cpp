@@ -0,0 +1,141 @@
+#include <set>
+#include <random>
+#include <catch.hpp>
+#include "benchmark.hpp"
+#include "data/itree.hpp"
+#include "data/ilist.hpp"
+
+using namespace Anaquin;
+
+static std::vector<Interval_<int>> random(std::size_t n, std::size_t len, std::mt19937 &g, std::size_t range = 1000000)
+{
+    std::vector<Interval_<int>> r;
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const std::size_t start = g() % range;
+        r.push_back(Interval_<int>(start, start + g() % len, i));
+    }
+
+    return r;
+}
+
+TEST_CASE("IList_Empty")
+{
+    IntervalList<int> t;
+
+    auto n = 0;
+    t.overlap(0, 100, [&](const Interval_<int> &) { n++; return true; });
+
+    REQUIRE(n == 0);
+}
+
+TEST_CASE("IList_1")
+{
+    std::vector<Interval_<int>> x;
+
+    for (auto i = 0; i < 10; i++)
+    {
+        x.push_back(Interval_<int>(10 * i + 1, 10 * i + 10, i));
+    }
+
+    IntervalList<int> t(x);
+
+    std::vector<int> r;
+    t.overlap(15, 31, [&](const Interval_<int> &i) { r.push_back(i.value); return true; });
+
+    REQUIRE(r == std::vector<int> { 3, 2, 1 });
+
+    r.clear();
+    t.contains(15, 18, [&](const Interval_<int> &i) { r.push_back(i.value); return true; });
+
+    REQUIRE(r == std::vector<int> { 1 });
+
+    r.clear();
+    t.contained(15, 31, [&](const Interval_<int> &i) { r.push_back(i.value); return true; });
+
+    REQUIRE(r == std::vector<int> { 2 });
+
+    // Early exit
+    r.clear();
+    t.overlap(1, 100, [&](const Interval_<int> &i) { r.push_back(i.value); return r.size() < 2; });
+
+    REQUIRE(r == std::vector<int> { 9, 8 });
+}
+
+TEST_CASE("IList_Random")
+{
+    std::mt19937 g(1);
+
+    for (auto len : { 10, 1000, 100000 })
+    {
+        const auto x = random(5000, len, g);
+
+        auto y = x;
+
+        IntervalTree<int> t1(y);
+        IntervalList<int> t2(x);
+
+        for (auto i = 0; i < 1000; i++)
+        {
+            const std::size_t start = g() % 1000000;
+            const std::size_t end = start + g() % 1000;
+
+            std::multiset<int> r1, r2, r3, r4;
+
+            for (const auto &j : t1.findOverlapping(start, end)) { r1.insert(j.value); }
+            for (const auto &j : t1.findContains(start, end))    { r3.insert(j.value); }
+
+            t2.overlap(start, end,  [&](const Interval_<int> &j) { r2.insert(j.value); return true; });
+            t2.contains(start, end, [&](const Interval_<int> &j) { r4.insert(j.value); return true; });
+
+            REQUIRE(r1 == r2);
+            REQUIRE(r3 == r4);
+        }
+    }
+}
+
+TEST_CASE("IList_Benchmark", "[.benchmark]")
+{
+    std::mt19937 g(1);
+
+    // Sparse (like exons) and dense intervals
+    for (auto range : { 100000000, 1000000 })
+    {
+        const auto x = random(200000, 500, g, range);
+
+        std::vector<std::size_t> q;
+
+        for (auto i = 0; i < 1000000; i++)
+        {
+            q.push_back(g() % range);
+        }
+
+        auto y = x;
+
+        IntervalTree<int> t1(y);
+        IntervalList<int> t2(x);
+
+        std::size_t n1 = 0, n2 = 0;
+
+        std::cout << "Range: " << range << std::endl;
+
+        benchmark("IntervalTree", [&]()
+        {
+            for (const auto &i : q)
+            {
+                n1 += t1.findOverlapping(i, i + 50).size();
+            }
+        });
+
+        benchmark("IntervalList", [&]()
+        {
+            for (const auto &i : q)
+            {
+                t2.overlap(i, i + 50, [&](const Interval_<int> &) { n2++; return true; });
+            }
+        });
+
+        REQUIRE(n1 == n2);
+    }
+}
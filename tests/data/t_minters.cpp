@@ -1,3 +1,4 @@
+#include <random>
 #include <catch.hpp>
 #include "data/minters.hpp"
 
@@ -12,18 +13,12 @@ TEST_CASE("Merged_11")
     i.map(Locus(2, 10));
 
     REQUIRE(i.size() == 1);
-    REQUIRE(i._data.count(10));
-    REQUIRE(!i._data.count(15));
-    REQUIRE(i._data[10].start == 2);
-    REQUIRE(i._data[10].end == 10);
+    REQUIRE(i.runs()[0] == Locus(2, 10));
     
     i.map(Locus(5, 15));
     
     REQUIRE(i.size() == 1);
-    REQUIRE(!i._data.count(10));
-    REQUIRE(i._data.count(15));
-    REQUIRE(i._data[15].start == 2);
-    REQUIRE(i._data[15].end == 15);
+    REQUIRE(i.runs()[0] == Locus(2, 15));
 }
 
 TEST_CASE("Merged_10")
@@ -311,4 +306,106 @@ TEST_CASE("Merged_5")
     
     REQUIRE(r.length   == 40);
     REQUIRE(r.nonZeros == 20);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Merged_12")
+{
+    MergedIntervals<> x;
+    
+    x.add(MergedInterval("1", Locus(1, 100)));
+    x.add(MergedInterval("2", Locus(50, 150)));
+    x.add(MergedInterval("3", Locus(200, 300)));
+    x.build();
+    
+    REQUIRE(x.firstExact(Locus(200, 300))->id() == "3");
+    REQUIRE(!x.firstExact(Locus(200, 299)));
+    REQUIRE(x.firstContains(Locus(210, 220))->id() == "3");
+    REQUIRE(!x.firstContains(Locus(90, 160)));
+    REQUIRE(x.firstOverlap(Locus(140, 210)));
+    REQUIRE(!x.firstOverlap(Locus(160, 190)));
+    
+    std::set<std::string> r;
+    
+    x.containing(Locus(60, 90), [&](MergedInterval *i)
+    {
+        r.insert(i->id());
+        return true;
+    });
+    
+    REQUIRE(r.size() == 2);
+
+    // Early exit
+    auto n = 0;
+    
+    x.overlapping(Locus(1, 300), [&](MergedInterval *)
+    {
+        return ++n < 2;
+    });
+    
+    REQUIRE(n == 2);
+    
+    std::vector<MergedInterval *> v;
+    
+    REQUIRE(x.overlap(Locus(1, 300), &v));
+    REQUIRE(v.size() == 3);
+}
+
+TEST_CASE("Merged_13")
+{
+    std::mt19937 g(1);
+    
+    MergedInterval i("Test", Locus(1, 100000));
+    
+    // Covered bases
+    std::vector<bool> x(100001, false);
+    
+    // Mostly sorted, sometimes backward
+    for (auto j = 0; j < 20000; j++)
+    {
+        const Base start = (j % 7) ? 1 + 5 * j : 1 + g() % 100000;
+        const auto l = Locus(start, start + g() % 50);
+        
+        i.add(l);
+        
+        for (auto k = l.start; k <= std::min(l.end, static_cast<Base>(100000)); k++)
+        {
+            x[k] = true;
+        }
+    }
+    
+    REQUIRE(i.stats().nonZeros == std::count(x.begin() + 1, x.end(), true));
+    
+    for (const auto &j : i.zeros())
+    {
+        for (auto k = j.start; k <= j.end; k++)
+        {
+            REQUIRE(!x[k]);
+        }
+    }
+    
+    // Sorted and non-overlapping
+    for (std::size_t j = 1; j < i.runs().size(); j++)
+    {
+        REQUIRE(i.runs()[j-1].end < i.runs()[j].start);
+    }
+}
+
+TEST_CASE("Merged_14")
+{
+    MergedInterval i("Test", Locus(1, 1000));
+    
+    Base l, r;
+    
+    REQUIRE(i.map(Locus(10, 20)) == 0);
+    REQUIRE(i.map(Locus(5, 25)) == 10);
+    REQUIRE(i.map(Locus(15, 30), &l, &r) == 5);
+    REQUIRE(l == 0);
+    REQUIRE(r == 5);
+
+    // Pending alignments are merged before the bases are counted
+    i.add(Locus(100, 200));
+    i.add(Locus(40, 50));
+    
+    REQUIRE(i.map(Locus(90, 210)) == 20);
+    REQUIRE(i.runs() == std::vector<Locus> { Locus(5, 30), Locus(40, 50), Locus(90, 210) });
+}
@@ -0,0 +1,71 @@
+#include <zlib.h>
+#include <fstream>
+#include <catch.hpp>
+#include "data/reader.hpp"
+
+using namespace Anaquin;
+
+static std::vector<std::string> lines(const Reader &r)
+{
+    std::string x;
+    std::vector<std::string> l;
+    
+    while (r.nextLine(x))
+    {
+        l.push_back(x);
+    }
+    
+    return l;
+}
+
+TEST_CASE("Reader_String")
+{
+    const auto l = lines(Reader("A\n\n  B \r\nC", DataMode::String));
+    
+    REQUIRE(l.size() == 3);
+    REQUIRE(l[0] == "A");
+    REQUIRE(l[1] == "B");
+    REQUIRE(l[2] == "C");
+}
+
+TEST_CASE("Reader_GZip")
+{
+    // Longer than a block
+    const auto x = std::string(3 << 20, 'A');
+    
+    {
+        std::ofstream w("/tmp/anaquin_reader.txt");
+        w << "chrIS\t1\t2\n" << x << "\nchrIS\t3\t4";
+    }
+    
+    {
+        auto f = gzopen("/tmp/anaquin_reader.txt.gz", "wb");
+        
+        // Two members, the same as bgzip
+        gzputs(f, "chrIS\t1\t2\n");
+        gzclose(f);
+        
+        f = gzopen("/tmp/anaquin_reader.txt.gz", "ab");
+        gzputs(f, (x + "\nchrIS\t3\t4").c_str());
+        gzclose(f);
+    }
+    
+    for (const auto &file : { "/tmp/anaquin_reader.txt", "/tmp/anaquin_reader.txt.gz" })
+    {
+        Reader r(file);
+
+        for (auto i = 0; i < 2; i++)
+        {
+            const auto l = lines(r);
+            
+            REQUIRE(l.size() == 3);
+            REQUIRE(l[0] == "chrIS\t1\t2");
+            REQUIRE(l[1] == x);
+            REQUIRE(l[2] == "chrIS\t3\t4");
+            
+            r.reset();
+        }
+        
+        REQUIRE(lines(Reader(r)).size() == 3);
+    }
+}
@@ -0,0 +1,90 @@
+#include <random>
+#include <catch.hpp>
+#include "data/sweep.hpp"
+#include "data/minters.hpp"
+
+using namespace Anaquin;
+
+TEST_CASE("Sweep_1")
+{
+    MergedIntervals<> x;
+    
+    x.add(MergedInterval("1", Locus(1, 100)));
+    x.add(MergedInterval("2", Locus(50, 150)));
+    x.add(MergedInterval("3", Locus(200, 300)));
+    x.build();
+
+    SweepIntervals<MergedInterval> s(x);
+    
+    s.advance(1);
+    REQUIRE(s.contains(Locus(10, 20))->id() == "1");
+    REQUIRE(s.exact(Locus(50, 150))->id() == "2");
+    
+    s.advance(160);
+    REQUIRE(!s.overlap(Locus(160, 190)));
+    REQUIRE(s.contains(Locus(210, 220))->id() == "3");
+    
+    // Going backward
+    s.advance(60);
+    REQUIRE(s.contains(Locus(60, 70))->id() == "1");
+}
+
+TEST_CASE("Sweep_Ties")
+{
+    MergedIntervals<> x;
+
+    x.add(MergedInterval("A", Locus(1, 100)));
+    x.add(MergedInterval("B", Locus(50, 150)));
+    x.add(MergedInterval("E", Locus(50, 120)));
+    x.add(MergedInterval("C", Locus(50, 120)));
+    x.build();
+
+    SweepIntervals<MergedInterval> s(x);
+    s.advance(60);
+
+    // The lowest start, then the lowest end, then the name
+    REQUIRE(x.firstOverlap(Locus(90, 130))->id()  == "A");
+    REQUIRE(s.overlap(Locus(90, 130))->id()       == "A");
+    REQUIRE(x.firstContains(Locus(60, 110))->id() == "C");
+    REQUIRE(s.contains(Locus(60, 110))->id()      == "C");
+    REQUIRE(x.firstExact(Locus(50, 120))->id()    == "C");
+    REQUIRE(s.exact(Locus(50, 120))->id()         == "C");
+}
+
+TEST_CASE("Sweep_Random")
+{
+    std::mt19937 g(1);
+    
+    MergedIntervals<> x;
+    
+    for (auto i = 0; i < 2000; i++)
+    {
+        const Base start = 1 + g() % 1000000;
+        x.add(MergedInterval(std::to_string(i), Locus(start, start + g() % 2000)));
+    }
+    
+    x.build();
+    
+    SweepIntervals<MergedInterval> s(x);
+    
+    std::vector<Base> starts;
+    
+    for (auto i = 0; i < 20000; i++)
+    {
+        starts.push_back(1 + g() % 1000000);
+    }
+    
+    std::sort(starts.begin(), starts.end());
+    
+    for (const auto &i : starts)
+    {
+        const auto l = Locus(i, i + g() % 100);
+        
+        s.advance(l.start);
+        
+        // The same tie-break as the index
+        REQUIRE(s.exact(l)    == x.firstExact(l));
+        REQUIRE(s.overlap(l)  == x.firstOverlap(l));
+        REQUIRE(s.contains(l) == x.firstContains(l));
+    }
+}
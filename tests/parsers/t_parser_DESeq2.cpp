@@ -0,0 +1,96 @@
+#include <catch.hpp>
+#include "test.hpp"
+#include "benchmark.hpp"
+#include "parsers/parser_DESeq2.hpp"
+
+using namespace Anaquin;
+
+// Gene ladder for the sequins R1_1 to R1_<n>
+static void geneLadder(unsigned n)
+{
+    clrTest();
+
+    UserReference r;
+    r.l1 = std::shared_ptr<Ladder>(new Ladder());
+    r.l2 = std::shared_ptr<Ladder>(new Ladder());
+
+    for (auto i = 1u; i <= n; i++)
+    {
+        r.l1->add("R1_" + std::to_string(i) + "_1", Mix_1, i);
+        r.l2->add("R1_" + std::to_string(i), Mix_1, i);
+    }
+
+    Standard::instance().r_rna.finalize(Tool::RnaFoldChange, r);
+}
+
+TEST_CASE("ParserDESeq2_Sequins")
+{
+    geneLadder(2);
+
+    REQUIRE(Standard::instance().r_rna.namesL1().count("R1_1_1"));
+    REQUIRE(Standard::instance().r_rna.namesL2().count("R1_2"));
+    REQUIRE(!Standard::instance().r_rna.namesL2().count("R1_1_1"));
+    REQUIRE(!Standard::instance().r_rna.namesL2().count("R1_3"));
+
+    std::vector<ParserDESeq2::Data> x;
+
+    ParserDESeq2::parse("tests/data/DESeq2.csv", [&](const ParserDESeq2::Data &d, const ParserProgress &)
+    {
+        x.push_back(d);
+    });
+
+    REQUIRE(!x.empty());
+
+    for (const auto &i : x)
+    {
+        REQUIRE(i.cID == (i.gID == "R1_1" || i.gID == "R1_2" ? ChrIS() : "endo"));
+    }
+}
+
+TEST_CASE("ParserDESeq2_Benchmark", "[.benchmark]")
+{
+    // About 200 sequin genes in a genome-wide table of 200000 rows
+    geneLadder(200);
+
+    const auto file = benchmarkFile("DESeq2.csv", [&](std::ostream &w)
+    {
+        w << ",baseMean,log2FoldChange,lfcSE,stat,pvalue,padj\n";
+
+        for (auto i = 0; i < 200000; i++)
+        {
+            const auto g = i % 1000 ? "ENSG" + std::to_string(10000000 + i) + ".1" : "R1_" + std::to_string(1 + i / 1000);
+            w << g << ",4603.84,-3.62,0.076,-47.65,0.01,0.02\n";
+        }
+    });
+
+    std::vector<GeneID> gIDs;
+
+    ParserDESeq2::parse(file, [&](const ParserDESeq2::Data &x, const ParserProgress &)
+    {
+        gIDs.push_back(x.gID);
+    });
+
+    const auto &r = Standard::instance().r_rna;
+
+    std::size_t n1 = 0, n2 = 0;
+
+    // Copying the sequins for every row, as seqsL2() did before it returned a reference
+    benchmark("Copied set", [&]()
+    {
+        for (const auto &i : gIDs)
+        {
+            n1 += std::set<SequinID>(r.seqsL2()).count(i);
+        }
+    });
+
+    benchmark("Hashed", [&]()
+    {
+        for (const auto &i : gIDs)
+        {
+            n2 += r.namesL2().count(i);
+        }
+    });
+
+    REQUIRE(n1 == 200);
+    REQUIRE(n1 == n2);
+}
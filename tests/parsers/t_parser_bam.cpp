@@ -100,6 +100,53 @@ TEST_CASE("Test_SoftClip")
     REQUIRE(r1[1].l.end   == 4106465);
 }
 
+TEST_CASE("Test_Threads")
+{
+    std::vector<Locus> r1, r2;
+    std::vector<ChrID> c1, c2;
+
+    ParserBAM::parse("tests/data/sequins.bam", [&](const ParserBAM::Data &x, const ParserBAM::Info &)
+    {
+        r1.push_back(x.l);
+        c1.push_back(x.cID);
+    });
+
+    ParserBAM::parse("tests/data/sequins.bam", [&](const ParserBAM::Data &x, const ParserBAM::Info &)
+    {
+        r2.push_back(x.l);
+        c2.push_back(x.cID);
+    }, false, 4);
+
+    REQUIRE(!r1.empty());
+    REQUIRE(r1 == r2);
+    REQUIRE(c1 == c2);
+}
+
+TEST_CASE("Test_TID")
+{
+    std::map<int, ChrID> r;
+    
+    ParserBAM::parse("tests/data/sequins.bam", [&](const ParserBAM::Data &x, const ParserBAM::Info &)
+    {
+        REQUIRE(x.cID == x.chr());
+        REQUIRE((x.tid() >= 0) == (x.cID != "*"));
+        
+        if (x.tid() >= 0)
+        {
+            REQUIRE((!r.count(x.tid()) || r[x.tid()] == x.cID));
+            r[x.tid()] = x.cID;
+        }
+    });
+    
+    REQUIRE(!r.empty());
+}
+
+TEST_CASE("Test_Sorted")
+{
+    REQUIRE(ParserBAM::sorted("tests/data/sequins.bam"));
+    REQUIRE(!ParserBAM::sorted("tests/data/insert.sam"));
+}
+
 //TEST_CASE("Test_Junction")
 //{
 //    std::vector<Alignment> aligns;
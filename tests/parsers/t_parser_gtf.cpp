@@ -1,5 +1,7 @@
 #include <catch.hpp>
+#include "benchmark.hpp"
 #include "parsers/parser_gtf2.hpp"
+#include "tools/gtf_data.hpp"
 
 using namespace Anaquin;
 
@@ -40,13 +42,150 @@ TEST_CASE("ParserGTF_1")
     REQUIRE(t2d["R1_63_1"].fpkm == 1783.9793649586);
 }
 
+TEST_CASE("ParserGTF_Tokens")
+{
+    const auto str = "# Comment\n"
+                     "chrIS\tAnaquin\ttranscript\t100\t200\t.\t+\t.\tgene_id \"R1_1\"; transcript_id \"R1_1_1\"; FPKM \"2.5\";\n"
+                     "chrIS\tAnaquin\tCDS\t100\t200\t.\t+\t.\tgene_id \"R1_2\";\n"
+                     "chrIS\tAnaquin\texon\t100\t150\t.\t-\t.\tgene_id R1_3;transcript_id \"R1_3_1\"; gene_name \"A B\"\n"
+                     "chrIS\tAnaquin\tgene\t1\t150\t.\t.\t.\tgene_id \"R1_4\"";
+
+    std::vector<ParserGTF::Data> x;
+
+    ParserGTF::parse(Reader(str, DataMode::String), [&](const ParserGTF::Data &i, const LineView &, const ParserProgress &)
+    {
+        x.push_back(i);
+    });
+
+    REQUIRE(x.size() == 3);
+
+    REQUIRE(x[0].cID     == "chrIS");
+    REQUIRE(x[0].type    == RNAFeature::Transcript);
+    REQUIRE(x[0].l.start == 100);
+    REQUIRE(x[0].l.end   == 200);
+    REQUIRE(x[0].str     == Strand::Forward);
+    REQUIRE(x[0].gID     == "R1_1");
+    REQUIRE(x[0].tID     == "R1_1_1");
+    REQUIRE(x[0].fpkm    == 2.5);
+
+    REQUIRE(x[1].type    == RNAFeature::Exon);
+    REQUIRE(x[1].str     == Strand::Backward);
+    REQUIRE(x[1].gID     == "R1_3");
+    REQUIRE(x[1].tID     == "R1_3_1");
+
+    REQUIRE(x[2].type    == RNAFeature::Gene);
+    REQUIRE(x[2].str     == Strand::Either);
+    REQUIRE(x[2].l.start == 1);
+    REQUIRE(x[2].gID     == "R1_4");
+
+    REQUIRE_THROWS(ParserGTF::parse(Reader("chrIS\tA\texon\t1\t2\t.\t*\t.\tgene_id \"R\";", DataMode::String),
+                                    [&](const ParserGTF::Data &, const LineView &, const ParserProgress &) {}));
+}
+
+TEST_CASE("ParserGTF_Split")
+{
+    const auto str = "# Comment\n"
+                     "chrIS\tAnaquin\ttranscript\t100\t200\t.\t+\t.\tgene_id \"R1_1\"; transcript_id \"R1_1_1\";\n"
+                     "chr1\tAnaquin\texon\t100\t150\t.\t-\t.\tgene_id \"chrIS\"; transcript_id \"G_1\";\n"
+                     "chrIS\tAnaquin\tgene\t1\t150\t.\t.\t.\tgene_id \"R1_4\"; gene_type \"synthetic\";\n"
+                     "chrISX\tAnaquin\texon\t100\t150\t.\t+\t.\tgene_id \"R1_5\";\n"
+                     "\n"
+                     "chrIS\tAnaquin\texon\t100\t150\t.\t+\t.\tgene_id \"R1_1\"; transcript_id \"R1_1_1\";";
+
+    const auto x = ParserGTF::split(Reader(str, DataMode::String), "chrIS", { "gene_type" });
+
+    REQUIRE(x.chr == "chrIS\tAnaquin\ttranscript\t100\t200\t.\t+\t.\tgene_id \"R1_1\"; transcript_id \"R1_1_1\";\n"
+                     "chrIS\tAnaquin\texon\t100\t150\t.\t+\t.\tgene_id \"R1_1\"; transcript_id \"R1_1_1\";\n");
+    REQUIRE(x.rest == "chr1\tAnaquin\texon\t100\t150\t.\t-\t.\tgene_id \"chrIS\"; transcript_id \"G_1\";\n"
+                      "chrISX\tAnaquin\texon\t100\t150\t.\t+\t.\tgene_id \"R1_5\";\n");
+
+    const auto y = ParserGTF::split(Reader(str, DataMode::String), "chrIS");
+
+    REQUIRE(std::count(y.chr.begin(),  y.chr.end(),  '\n') == 3);
+    REQUIRE(std::count(y.rest.begin(), y.rest.end(), '\n') == 2);
+}
+
+/*
+ * Attributes before the in-place tokenizer, for comparison
+ */
+
+static void slowParse(const Reader &r, std::size_t &n)
+{
+    std::string line;
+    std::vector<std::string> toks, opts, nameVal;
+
+    while (r.nextLine(line))
+    {
+        boost::split(toks, line, boost::is_any_of("\t"));
+        
+        if (toks.size() == 1)
+        {
+            continue;
+        }
+
+        n += stoi(toks[3]) + stoi(toks[4]);
+        boost::split(opts, toks[8], boost::is_any_of(";"));
+        
+        for (auto option : opts)
+        {
+            if (!option.empty())
+            {
+                boost::trim(option);
+                boost::split(nameVal, option, boost::is_any_of(" "));
+                
+                if (nameVal.size() == 2)
+                {
+                    nameVal[1].erase(std::remove(nameVal[1].begin(), nameVal[1].end(), '\"'), nameVal[1].end());
+                    
+                    if (nameVal[0] == "gene_id" || nameVal[0] == "transcript_id")
+                    {
+                        n += nameVal[1].size();
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ParserGTF_Benchmark", "[.benchmark]")
+{
+    // GENCODE has about three millions of lines
+    const auto file = benchmarkFile("benchmark.gtf", [&](std::ostream &w)
+    {
+        for (auto i = 0; i < 3000000; i++)
+        {
+            const auto g = "ENSG" + std::to_string(10000000 + i / 40) + ".1";
+            const auto t = "ENST" + std::to_string(10000000 + i / 10) + ".1";
+
+            w << "chr" << (1 + i % 22) << "\tHAVANA\t" << (i % 10 ? "exon" : "transcript") << "\t" << 1000 + i << "\t" << 2000 + i
+              << "\t.\t+\t.\tgene_id \"" << g << "\"; transcript_id \"" << t << "\"; gene_type \"protein_coding\"; "
+              << "gene_name \"DDX11L1\"; transcript_type \"processed_transcript\"; transcript_name \"DDX11L1-002\"; "
+              << "exon_number 1; level 2; tag \"basic\"; transcript_support_level \"1\";\n";
+        }
+    });
+
+    std::size_t n1 = 0, n2 = 0;
+    
+    benchmark("boost::split", [&]() { slowParse(Reader(file), n1); });
+    
+    benchmark("In-place", [&]()
+    {
+        ParserGTF::parse(Reader(file), [&](const ParserGTF::Data &x, const LineView &, const ParserProgress &)
+        {
+            n2 += x.l.start + x.l.end + x.gID.size() + x.tID.size();
+        });
+    });
+    
+    REQUIRE(n1 == n2);
+}
+
 #ifdef INTERNAL_TESTING
 
 TEST_CASE("ParserGTF_Gencode")
 {
     std::vector<Feature> fs;
     
-    ParserGTF::parse(Reader("tests/data/GeneCodeV23Annotation.gtf"), [&](const ParserGTF::Data &f, const std::string &, const ParserProgress &)
+    ParserGTF::parse(Reader("tests/data/GeneCodeV23Annotation.gtf"), [&](const ParserGTF::Data &f, const LineView &, const ParserProgress &)
     {
         fs.push_back(f);
     });
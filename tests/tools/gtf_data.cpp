@@ -1,8 +1,25 @@
+#include <random>
+#include <thread>
+#include <fstream>
 #include <catch.hpp>
+#include "benchmark.hpp"
 #include "tools/gtf_data.hpp"
 
 using namespace Anaquin;
 
+// Number of transcripts with unique exons
+static Counts nTrans(const GTFData &x, const ChrID &cID)
+{
+    std::set<NameID> r;
+    
+    for (const auto &i : x.ues.rows(x.cIDs.at(cID)))
+    {
+        r.insert(i.t);
+    }
+    
+    return r.size();
+}
+
 //TEST_CASE("GTF_Synthetic")
 //{
 //    const auto r = gtfData(Reader("data/RnaQuin/A.R.1.gtf"));
@@ -89,8 +106,8 @@ TEST_CASE("GTF_Merged")
     REQUIRE(r.countUIntrGen() == 4214);
     REQUIRE(r.countUExonGen() == 6540);
     
-    REQUIRE(r.at(ChrIS()).t2ue.size() == 162);
-    REQUIRE(r.at("chr21").t2ue.size() == 2370);
+    REQUIRE(nTrans(r, ChrIS()) == 162);
+    REQUIRE(nTrans(r, "chr21")  == 2370);
 
     const auto i = r.gIntervals(ChrIS());
 
@@ -109,6 +126,121 @@ TEST_CASE("GTF_Merged")
     REQUIRE(r.uiInters("chr21").size() == 4214); // 11553 for non-unique
 }
 
+TEST_CASE("GTF_Columnar")
+{
+    const auto r = gtfData(Reader("tests/data/A1.gtf"));
+    
+    REQUIRE(r.chrs() == std::vector<ChrID> { "chrIS" });
+    REQUIRE(r.cIDs.size() == 1);
+    REQUIRE(r.countTrans() == 164);
+    REQUIRE(r.tIDs.size()  == 164);
+    REQUIRE(r.countUExon() == 875);
+    REQUIRE(r.countUIntr() == 740);
+    
+    // Names are interned
+    REQUIRE(r.tIDs[r.tIDs.at("R1_11_1")] == "R1_11_1");
+    REQUIRE(!r.gIDs.count("R1_11_1"));
+    
+    const auto &x = r.ues.x;
+    
+    // Sorted by the transcript names and then the positions
+    for (std::size_t i = 1; i < x.size(); i++)
+    {
+        const auto &t1 = r.tIDs[x[i-1].t];
+        const auto &t2 = r.tIDs[x[i].t];
+        
+        REQUIRE((t1 < t2 || (t1 == t2 && x[i-1] < x[i])));
+    }
+    
+    const auto e = r.ueInters(ChrIS());
+    const auto i = r.uiInters(ChrIS());
+
+    REQUIRE(e.size() == 875);
+    REQUIRE(i.size() == 740);
+    REQUIRE(r.meInters(ChrIS(), Strand::Either).size() < e.size());
+    
+    for (const auto &j : x)
+    {
+        const auto m = e.find(r.tIDs[j.t] + "-" + std::to_string(j.start) + "-" + std::to_string(j.end));
+
+        REQUIRE(m);
+        REQUIRE(m->gID() == r.gIDs[j.g]);
+    }
+}
+
+TEST_CASE("GTF_Memo")
+{
+    const auto r = gtfData(Reader("tests/data/A1.gtf"));
+
+    // Built once
+    REQUIRE(&r.meInters(Strand::Either) == &r.meInters(Strand::Either));
+    REQUIRE(&r.meInters(Strand::Either) != &r.meInters(Strand::Forward));
+    REQUIRE(&r.uiInters() == &r.uiInters());
+    
+    // No gene is defined, nothing is memorised
+    REQUIRE_THROWS(r.gIntervals(ChrIS()));
+    REQUIRE_THROWS(r.gIntervals(ChrIS()));
+    
+    auto x = r.meInters(Strand::Either);
+    const auto &l = x.at(ChrIS()).data().begin()->second.l();
+    
+    // A copy has its own index
+    x.at(ChrIS()).firstContains(l)->map(l);
+    
+    REQUIRE(x.at(ChrIS()).stats().nonZeros == l.length());
+    REQUIRE(r.meInters(Strand::Either).at(ChrIS()).stats().nonZeros == 0);
+    
+    // A copy has its own intervals
+    const auto c = r;
+    REQUIRE(&c.uiInters() != &r.uiInters());
+    REQUIRE(c.uiInters().at(ChrIS()).size() == r.uiInters().at(ChrIS()).size());
+}
+
+TEST_CASE("GTF_GeneSnapshot")
+{
+    std::string str;
+    
+    for (auto i = 0; i < 20; i++)
+    {
+        for (auto j = 0; j < 10; j++)
+        {
+            str += "chr" + std::to_string(i) + "\tA\tgene\t" + std::to_string(100 * j + 1) + "\t" + std::to_string(100 * j + 50) +
+                   "\t.\t+\t.\tgene_id \"G" + std::to_string(i) + "_" + std::to_string(j) + "\";\n";
+        }
+    }
+    
+    const auto r = gtfData(Reader(str, DataMode::String));
+    
+    // Chromosomes built by other threads while the snapshots are taken
+    std::vector<std::thread> t;
+    
+    for (auto i = 0; i < 4; i++)
+    {
+        t.push_back(std::thread([&, i]()
+        {
+            for (auto j = i; j < 20; j += 4)
+            {
+                r.gIntervals("chr" + std::to_string(j));
+            }
+        }));
+    }
+    
+    const auto x = r.gIntervals();
+
+    for (auto &i : t)
+    {
+        i.join();
+    }
+    
+    REQUIRE(x.size() == 20);
+    
+    for (const auto &i : x)
+    {
+        REQUIRE(i.second.size() == 10);
+        REQUIRE(&r.gIntervals(i.first) != &i.second);
+    }
+}
+
 //#ifdef GENCODE_TEST
 //
 ///*
@@ -137,3 +269,94 @@ TEST_CASE("GTF_Merged")
 //}
 //
 //#endif
+
+/*
+ * Full GENCODE if it's downloaded (eg: tests/data/gencode.v24.annotation.gtf.gz), otherwise an annotation
+ * of a similar size (60k genes, 200k transcripts and 1.2m exons).
+ */
+
+TEST_CASE("GTF_Benchmark", "[.benchmark]")
+{
+    FileName file = "tests/data/gencode.v24.annotation.gtf.gz";
+    
+    if (!std::ifstream(file).good())
+    {
+        file = benchmarkFile("gencode.gtf", [&](std::ostream &w)
+        {
+            std::mt19937 g(1);
+
+            for (auto i = 0; i < 60000; i++)
+            {
+                const Base pos = 1000 + (i / 22) * 50000;
+                const auto gID = "ENSG" + std::to_string(10000000 + i);
+                const auto str = i % 2 ? "+" : "-";
+                const auto cID = "chr" + std::to_string(1 + i % 22);
+
+                for (auto j = 0; j < 3; j++)
+                {
+                    const auto tID = "ENST" + std::to_string(10000000 + 3 * i + j);
+                
+                    w << cID << "\tHAVANA\ttranscript\t" << pos << "\t" << pos + 40000 << "\t.\t" << str
+                      << "\t.\tgene_id \"" << gID << "\"; transcript_id \"" << tID << "\";\n";
+
+                    // Exons are shared by the transcripts for alternative splicing
+                    for (Base k = 0, s = pos; k < 6; k++, s += 2000 + g() % 2000)
+                    {
+                        w << cID << "\tHAVANA\texon\t" << s << "\t" << s + 100 + g() % 200 << "\t.\t" << str
+                          << "\t.\tgene_id \"" << gID << "\"; transcript_id \"" << tID << "\";\n";
+                    }
+                }
+            }
+        });
+    }
+    
+    GTFData x;
+    benchmark("gtfData", [&]() { x = gtfData(Reader(file)); });
+    benchmark("Intervals", [&]() { x.meInters(Strand::Either); x.uiInters(); });
+
+    const auto rows = x.gs.x.size() + x.ts.x.size() + x.ues.x.size() + x.uis.x.size();
+    std::cout << "Rows: " << rows << " (" << rows * sizeof(Feature) / 1024 / 1024 << " MB)" << std::endl;
+
+    std::vector<ParserGTF::Data> exons;
+    
+    ParserGTF::parse(Reader(file), [&](const ParserGTF::Data &i, const LineView &, const ParserProgress &)
+    {
+        if (i.type == RNAFeature::Exon)
+        {
+            exons.push_back(i);
+        }
+    });
+
+    // Unique exons by string keys, the same as before
+    std::cout << "Exons: " << exons.size() << std::endl;
+
+    std::map<std::string, Locus> m1;
+
+    benchmark("boost::format", [&]()
+    {
+        for (const auto &i : exons)
+        {
+            const auto key = (boost::format("%1%_%2%_%3%-%4%") % i.cID % i.str % i.l.start % i.l.end).str();
+            
+            if (!m1.count(key))
+            {
+                m1[key] = i.l;
+            }
+        }
+    });
+
+    UniqueSet m2;
+    std::map<ChrID, std::size_t> c2i;
+
+    benchmark("Integer keys", [&]()
+    {
+        for (const auto &i : exons)
+        {
+            const auto n = c2i.size();
+            m2.insert(UniqueKey { c2i.insert(std::make_pair(i.cID, n)).first->second, i.str, i.l.start, i.l.end });
+        }
+    });
+    
+    REQUIRE(m1.size() == m2.size());
+    REQUIRE(static_cast<Counts>(m1.size()) == x.countUExon());
+}
@@ -1,5 +1,7 @@
 #include <catch.hpp>
 #include "tools/sample.hpp"
+#include "parsers/parser_bam.hpp"
+#include "writers/bam_writer.hpp"
 
 using namespace Anaquin;
 
@@ -41,4 +43,119 @@ TEST_CASE("SamplingTool_All")
     }
     
     REQUIRE(n == 100);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Random_Seed")
+{
+    Random r1(0.5, 1);
+    Random r2(0.5, 1);
+    Random r3(0.5, 2);
+    
+    std::size_t n = 0;
+    
+    for (auto i = 0; i < 1000; i++)
+    {
+        const auto x = "HWI-ST1234:8:1101:" + std::to_string(i);
+        
+        // The same seed, the same decisions (both mates have the same name)
+        REQUIRE(r1.select(x) == r2.select(x));
+        REQUIRE(r1.select(x) == r1.select(x.c_str()));
+        
+        if (r1.select(x) != r3.select(x)) { n++; }
+    }
+    
+    // Different seeds, different decisions
+    REQUIRE(n > 300);
+    REQUIRE(n < 700);
+}
+
+TEST_CASE("Sampler_Output")
+{
+    const auto src = "tests/data/indexed.bam";
+    const auto out = "/tmp/anaquin_sampled.bam";
+
+    const auto r = Sampler::sample(src, 0.5, AnalyzerOptions(), [&](const ChrID &x)
+    {
+        return x == "chrIS";
+    }, out, 1);
+
+    REQUIRE(r.after.syn > 0);
+    REQUIRE(r.after.syn < r.before.syn);
+
+    Sampler::SGReads x;
+    
+    ParserBAM::parse(out, [&](ParserBAM::Data &i, const ParserBAM::Info &)
+    {
+        if (i.isPrimary && i.isAligned)
+        {
+            if (i.cID == "chrIS") { x.syn++; } else { x.gen++; }
+        }
+    });
+    
+    REQUIRE(x.syn == r.after.syn);
+    REQUIRE(x.gen == r.after.gen);
+    REQUIRE(ParserBAM::header(out) == ParserBAM::header(src));
+}
+
+TEST_CASE("Sampler_EmptyOutput")
+{
+    const auto src = "tests/data/indexed.bam";
+    const auto out = "/tmp/anaquin_empty.bam";
+
+    BAMWriter w;
+    w.open(out, src);
+    w.close();
+    
+    std::size_t n = 0;
+    
+    ParserBAM::parse(out, [&](ParserBAM::Data &, const ParserBAM::Info &)
+    {
+        n++;
+    });
+
+    // Header only
+    REQUIRE(n == 0);
+    REQUIRE(ParserBAM::header(out) == ParserBAM::header(src));
+}
+
+TEST_CASE("Sampler_Threads")
+{
+    // 14000 alignments, several batches for the workers
+    const auto src = "tests/data/test2.bam";
+    
+    std::vector<std::vector<std::string>> names;
+    std::vector<Sampler::Stats> stats;
+    
+    for (auto thr : { 1, 2, 4 })
+    {
+        AnalyzerOptions o;
+        o.thr = thr;
+        
+        const auto out = "/tmp/anaquin_sampled_" + std::to_string(thr) + ".bam";
+
+        // Everything on chr1 is sampled
+        stats.push_back(Sampler::sample(src, 0.3, o, [&](const ChrID &x)
+        {
+            return x == "chr1";
+        }, out, 7));
+
+        names.push_back(std::vector<std::string>());
+        
+        ParserBAM::parse(out, [&](ParserBAM::Data &x, const ParserBAM::Info &)
+        {
+            x.lName();
+            names.back().push_back(x.name);
+        });
+    }
+    
+    REQUIRE(stats[0].after.syn > 0);
+    REQUIRE(stats[0].after.syn < stats[0].before.syn);
+    
+    for (std::size_t i = 1; i < stats.size(); i++)
+    {
+        REQUIRE(stats[i].before.syn == stats[0].before.syn);
+        REQUIRE(stats[i].before.gen == stats[0].before.gen);
+        REQUIRE(stats[i].after.syn  == stats[0].after.syn);
+        REQUIRE(names[i] == names[0]);
+    }
+}
@@ -1,4 +1,8 @@
+#include <random>
+#include <cstring>
+#include <sstream>
 #include <catch.hpp>
+#include "benchmark.hpp"
 #include "tools/samtools.hpp"
 #include "parsers/parser_bam.hpp"
 
@@ -30,3 +34,142 @@ TEST_CASE("HT_Test2")
     REQUIRE(r1[2]  == "40M");
     REQUIRE(r1[24] == "44M3D80M");
 }
+
+// Decoders before the table-driven versions, for comparison
+static std::string slowSeq(bam1_t *x)
+{
+    std::stringstream buf;
+    
+    for (auto i = 0; i < x->core.l_qseq; ++i)
+    {
+        buf << seq_nt16_str[bam_seqi(bam_get_seq(x),i)];
+    }
+    
+    return buf.str();
+}
+
+static std::string slowQual(bam1_t *x)
+{
+    std::stringstream buf;
+    
+    for (auto i = 0; i < x->core.l_qseq; ++i)
+    {
+        buf << (char) (bam_get_qual(x)[i] + 33);
+    }
+    
+    return buf.str();
+}
+
+// Alignment with random sequence and quality, cigar is "<n>M"
+static bam1_t *random(std::mt19937 &g, int n)
+{
+    auto t = bam_init1();
+    
+    t->core.l_qname = 4;
+    t->core.n_cigar = 1;
+    t->core.l_qseq  = n;
+    t->l_data = t->core.l_qname + 4 + (n + 1) / 2 + n;
+    t->m_data = t->l_data;
+    t->data   = static_cast<uint8_t *>(realloc(t->data, t->m_data));
+    
+    memcpy(t->data, "r1\0\0", 4);
+    
+    const uint32_t c = (static_cast<uint32_t>(n) << BAM_CIGAR_SHIFT) | BAM_CMATCH;
+    memcpy(t->data + 4, &c, 4);
+    
+    for (auto i = 0; i < (n + 1) / 2; i++)
+    {
+        bam_get_seq(t)[i] = g() % 256;
+    }
+    
+    for (auto i = 0; i < n; i++)
+    {
+        bam_get_qual(t)[i] = g() % 42;
+    }
+    
+    return t;
+}
+
+TEST_CASE("HT_Decode")
+{
+    std::mt19937 g(1);
+    
+    std::string s, q, c;
+    
+    for (auto n : { 0, 1, 2, 75, 150, 151 })
+    {
+        auto t = random(g, n);
+        
+        bam2seq(t, s);
+        bam2qual(t, q);
+        bam2cigar(t, c);
+        
+        REQUIRE(s == slowSeq(t));
+        REQUIRE(q == slowQual(t));
+        REQUIRE(c == std::to_string(n) + "M");
+        
+        bam_destroy1(t);
+    }
+}
+
+TEST_CASE("HT_InvalidCigar")
+{
+    std::mt19937 g(1);
+    
+    auto t = random(g, 10);
+    
+    std::string c;
+    
+    // Operations beyond "MIDNSHP=XB" are invalid
+    for (uint32_t op = 10; op < 16; op++)
+    {
+        const uint32_t x = (10 << BAM_CIGAR_SHIFT) | op;
+        memcpy(bam_get_cigar(t), &x, 4);
+        
+        bam2cigar(t, c);
+        REQUIRE(c == "10?");
+    }
+    
+    bam_destroy1(t);
+}
+
+TEST_CASE("HT_Benchmark", "[.benchmark]")
+{
+    std::mt19937 g(1);
+    
+    std::vector<bam1_t *> x;
+    
+    for (auto i = 0; i < 100000; i++)
+    {
+        x.push_back(random(g, 150));
+    }
+    
+    std::size_t n1 = 0, n2 = 0;
+    
+    benchmark("stringstream", [&]()
+    {
+        for (const auto &i : x)
+        {
+            n1 += slowSeq(i).size() + slowQual(i).size();
+        }
+    });
+    
+    std::string s, q;
+    
+    benchmark("Table-driven", [&]()
+    {
+        for (const auto &i : x)
+        {
+            bam2seq(i, s);
+            bam2qual(i, q);
+            n2 += s.size() + q.size();
+        }
+    });
+    
+    REQUIRE(n1 == n2);
+    
+    for (auto &i : x)
+    {
+        bam_destroy1(i);
+    }
+}